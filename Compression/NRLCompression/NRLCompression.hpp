@@ -9,6 +9,7 @@
 #include "../../Utilities/utilities.hpp"
 #include "../../names.hpp"
 #include "../../AbstractBit/AbstractBitWriter/AbstractBitWriter.hpp"
+#include "../../Kernels/RunKernels.hpp"
 
 namespace GC {
 
@@ -23,37 +24,6 @@ namespace GC {
     private:
         Unit escapeCharacter = 0xff; //very arbitrary
 
-        std::vector<RLPair> getRLPairs(const Block& block) {
-            std::vector<RLPair> pairs;
-            Unit currentUnit;
-            Amount currentAmount;
-
-            auto startNewRun = [&](const Unit startingUnit){
-                currentUnit = startingUnit;
-                currentAmount = 1;
-            };
-
-            auto finishCurrentRun = [&]() {
-                pairs.push_back({currentUnit, currentAmount});
-            };
-
-            if (block.empty())
-                return pairs;
-
-            startNewRun(block[0]);
-            for (size_t i=1;i<block.size();i++) {
-                const Unit newUnit = block[i];
-                if (newUnit == currentUnit)
-                    currentAmount++;
-                else {
-                    finishCurrentRun();
-                    startNewRun(newUnit);
-                }
-            }
-            finishCurrentRun();
-            return pairs;
-        }
-
         void encodeEscapedPair(const RLPair& rlPair, AbstractBitWriter& writer) {
             writer.writeByte(escapeCharacter);
             writer.writeByte(rlPair.unit);
@@ -83,44 +53,31 @@ namespace GC {
             return result;
         }
 
-        std::vector<RLPair> decodeRLPairs(AbstractBitReader& reader) {
-            size_t expectedAmount = reader.readSmallAmount();
-            std::vector<RLPair> pairs;
-            auto decodeAndSavePair = [&](){pairs.push_back(decodeRLPair(reader));};
-            repeat(expectedAmount, decodeAndSavePair);
-            return pairs;
-        }
-
-        Block expressRLPairs(const std::vector<RLPair>& pairs) {
-            Block result;
-            auto expressPair = [&](const RLPair& rlPair) {
-                repeat(rlPair.amount, [&](){result.push_back(rlPair.unit);});
-            };
-            std::for_each(pairs.begin(), pairs.end(), expressPair);
-            return result;
-        }
-
-        void log_pairs(const std::vector<RLPair>& pairs) {
-            //LOG("The pairs are");
-            auto logPair = [&](const RLPair pair) {
-                //LOG("Character: ", (uint16_t)pair.unit, ", Amount:", pair.amount);
-            };
-            std::for_each(pairs.begin(), pairs.end(), logPair);
+        //the run is appended as a single fill (a memset for bytes), rather than a unit at a time
+        void expressRLPair(const RLPair& rlPair, Block& result) {
+            result.insert(result.end(), rlPair.amount, rlPair.unit);
         }
 
 
     public:
+        /**
+         * The amount of runs is written first, so it's counted beforehand, and then the runs are encoded as they are found
+         */
         virtual void compress(const Block& block, AbstractBitWriter& writer) {
-            std::vector<RLPair> rlPairs = getRLPairs(block);
-            log_pairs(rlPairs);
-            writer.writeSmallAmount(rlPairs.size());
-            for (const auto& rlPair: rlPairs) encodeRLPair(rlPair, writer);
+            const RunKernels& runKernels = getRunKernels();
+            writer.writeSmallAmount(runKernels.countRuns(block.data(), block.size()));
+            for (size_t runStart = 0; runStart < block.size();) {
+                const size_t runEnd = runKernels.findRunEnd(block.data(), runStart, block.size());
+                encodeRLPair({block[runStart], runEnd-runStart}, writer);
+                runStart = runEnd;
+            }
         }
 
         virtual Block decompress(AbstractBitReader& reader) {
-            std::vector<RLPair> pairs = decodeRLPairs(reader);
-            log_pairs(pairs);
-            return expressRLPairs(pairs);
+            const size_t expectedAmount = reader.readSmallAmount();
+            Block result;
+            repeat(expectedAmount, [&](){expressRLPair(decodeRLPair(reader), result);});
+            return result;
         }
 
         virtual std::string to_string() const {
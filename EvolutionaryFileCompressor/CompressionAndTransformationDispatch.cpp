@@ -24,6 +24,8 @@
 #include "../Compression/LZWCompression/LZWCompression.hpp"
 #include "../Transformation/Transformations/BurrowsWheelerTransform.hpp"
 #include "../Transformation/Transformations/SubMinAdaptiveTransform.hpp"
+#include "../Transformation/Transformations/BlockSortingTransform.hpp"
+#include "../Transformation/Transformations/LaneDeltaTransform.hpp"
 
 namespace GC {
     void EvolutionaryFileCompressor::applyCompressionCode(const EvolutionaryFileCompressor::CompressionCode &cc, const Block &block, AbstractBitWriter& writer) {
@@ -33,6 +35,7 @@ namespace GC {
             case C_RunLengthCompression:    return NRLCompression().compress(block, writer);
             case C_SmallValueCompression:   return SmallValueCompression().compress(block, writer);
             case C_LZWCompression:          return LZWCompression().compress(block, writer);
+            case C_AmountOfCCodes:          ASSERT_NOT_REACHED();
         }
     }
 
@@ -40,6 +43,8 @@ namespace GC {
                                                         Block &block) {
 #define GC_APPLY_T_CASE_X(TRANS, ...) case T_##TRANS : TRANS(__VA_ARGS__).apply(block);break
 #define GC_APPLY_T_STRIDE_CASE_X(NUM) case T_StrideTransform_##NUM : StrideTransform(NUM).apply(block); break;
+#define GC_APPLY_T_LANE_CASE(BITS) case T_DeltaTransform_##BITS : LaneDeltaTransform(BITS/8, false).apply(block); break; \
+                                   case T_DeltaXORTransform_##BITS : LaneDeltaTransform(BITS/8, true).apply(block); break;
         switch (tc) {
             GC_APPLY_T_CASE_X(DeltaTransform);
             GC_APPLY_T_CASE_X(DeltaXORTransform);
@@ -49,21 +54,62 @@ namespace GC {
             GC_APPLY_T_STRIDE_CASE_X(2);
             GC_APPLY_T_STRIDE_CASE_X(3);
             GC_APPLY_T_STRIDE_CASE_X(4);
+            GC_APPLY_T_STRIDE_CASE_X(8);
+            GC_APPLY_T_STRIDE_CASE_X(12);
+            GC_APPLY_T_STRIDE_CASE_X(16);
             GC_APPLY_T_CASE_X(SubtractAverageTransform);
             GC_APPLY_T_CASE_X(SubtractXORAverageTransform);
             GC_APPLY_T_CASE_X(IdentityTransform);
             GC_APPLY_T_CASE_X(LempelZivWelchTransform);
             GC_APPLY_T_CASE_X(BurrowsWheelerTransform);
             GC_APPLY_T_CASE_X(SubMinAdaptiveTransform);
+            GC_APPLY_T_CASE_X(BlockSortingTransform);
+            GC_APPLY_T_LANE_CASE(16);
+            GC_APPLY_T_LANE_CASE(32);
+            GC_APPLY_T_LANE_CASE(64);
+            case T_AmountOfTCodes: ASSERT_NOT_REACHED();
         }
 
     }
 
+    void EvolutionaryFileCompressor::applyTransformCode(const TransformCode &tc, const Block &input, Block &output) {
+#define GC_APPLY_INTO_T_CASE(TRANS, ...) case T_##TRANS : TRANS(__VA_ARGS__).apply_into(input, output);break;
+#define GC_APPLY_INTO_T_STRIDE_CASE(NUM) case T_StrideTransform_##NUM : StrideTransform(NUM).apply_into(input, output); break;
+#define GC_APPLY_INTO_T_LANE_CASE(BITS) case T_DeltaTransform_##BITS : LaneDeltaTransform(BITS/8, false).apply_into(input, output); break; \
+                                        case T_DeltaXORTransform_##BITS : LaneDeltaTransform(BITS/8, true).apply_into(input, output); break;
+        switch (tc) {
+            GC_APPLY_INTO_T_CASE(DeltaTransform);
+            GC_APPLY_INTO_T_CASE(DeltaXORTransform);
+            GC_APPLY_INTO_T_CASE(RunLengthTransform);
+            GC_APPLY_INTO_T_CASE(StackTransform);
+            GC_APPLY_INTO_T_CASE(SplitTransform);
+            GC_APPLY_INTO_T_STRIDE_CASE(2);
+            GC_APPLY_INTO_T_STRIDE_CASE(3);
+            GC_APPLY_INTO_T_STRIDE_CASE(4);
+            GC_APPLY_INTO_T_STRIDE_CASE(8);
+            GC_APPLY_INTO_T_STRIDE_CASE(12);
+            GC_APPLY_INTO_T_STRIDE_CASE(16);
+            GC_APPLY_INTO_T_CASE(SubtractAverageTransform);
+            GC_APPLY_INTO_T_CASE(SubtractXORAverageTransform);
+            GC_APPLY_INTO_T_CASE(IdentityTransform);
+            GC_APPLY_INTO_T_CASE(LempelZivWelchTransform);
+            GC_APPLY_INTO_T_CASE(BurrowsWheelerTransform);
+            GC_APPLY_INTO_T_CASE(SubMinAdaptiveTransform);
+            GC_APPLY_INTO_T_CASE(BlockSortingTransform);
+            GC_APPLY_INTO_T_LANE_CASE(16);
+            GC_APPLY_INTO_T_LANE_CASE(32);
+            GC_APPLY_INTO_T_LANE_CASE(64);
+            case T_AmountOfTCodes: ASSERT_NOT_REACHED();
+        }
+    }
+
     void EvolutionaryFileCompressor::undoTransformCode(const TransformCode& tc, Block& block) {
         //LOG("undoing transform", Individual::TCode_as_string(tc), ", size was", block.size());
 
 #define GC_UNDO_T_CASE(TRANS, ...) case T_##TRANS : TRANS(__VA_ARGS__).undo(block);break;
 #define GC_UNDO_T_STRIDE_CASE(NUM) case T_StrideTransform_##NUM : StrideTransform(NUM).undo(block);break;
+#define GC_UNDO_T_LANE_CASE(BITS) case T_DeltaTransform_##BITS : LaneDeltaTransform(BITS/8, false).undo(block); break; \
+                                  case T_DeltaXORTransform_##BITS : LaneDeltaTransform(BITS/8, true).undo(block); break;
         switch (tc) {
             GC_UNDO_T_CASE(DeltaTransform);
             GC_UNDO_T_CASE(DeltaXORTransform);
@@ -73,12 +119,20 @@ namespace GC {
             GC_UNDO_T_STRIDE_CASE(2);
             GC_UNDO_T_STRIDE_CASE(3);
             GC_UNDO_T_STRIDE_CASE(4);
+            GC_UNDO_T_STRIDE_CASE(8);
+            GC_UNDO_T_STRIDE_CASE(12);
+            GC_UNDO_T_STRIDE_CASE(16);
             GC_UNDO_T_CASE(SubtractAverageTransform);
             GC_UNDO_T_CASE(SubtractXORAverageTransform);
             GC_UNDO_T_CASE(IdentityTransform);
             GC_UNDO_T_CASE(LempelZivWelchTransform);
             GC_UNDO_T_CASE(BurrowsWheelerTransform);
             GC_UNDO_T_CASE(SubMinAdaptiveTransform);
+            GC_UNDO_T_CASE(BlockSortingTransform);
+            GC_UNDO_T_LANE_CASE(16);
+            GC_UNDO_T_LANE_CASE(32);
+            GC_UNDO_T_LANE_CASE(64);
+            case T_AmountOfTCodes: ASSERT_NOT_REACHED();
         }
         //LOG("The new block size is", block.size());
     }
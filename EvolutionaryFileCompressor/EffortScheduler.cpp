@@ -0,0 +1,66 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "EffortScheduler.hpp"
+#include "../BlockReport/BlockReport.hpp"
+
+namespace GC {
+
+    void EffortScheduler::Allocation::applyTo(Evolver::EvolutionSettings& evoSettings) const {
+        if (evaluations > 0) evoSettings.evaluationBudget = evaluations;
+        if (time.count() > 0) evoSettings.timeBudget = evoSettings.timeBudget ? std::min(*evoSettings.timeBudget, time) : time;
+    }
+
+    EffortScheduler::EffortScheduler(const size_t fileSize, const size_t evaluationBudget, const Milliseconds timeBudget) :
+        hasEvaluationBudget(evaluationBudget > 0),
+        hasTimeBudget(timeBudget.count() > 0),
+        remainingEvaluations(evaluationBudget),
+        remainingTime(timeBudget),
+        remainingBytes(fileSize) {
+    }
+
+    double EffortScheduler::getHeadroom(const Block& block) {
+        if (block.empty()) return minimumHeadroom;
+        const double entropy = BlockReport::getEntropy(BlockReport::getFrequencyArray(block));
+        return std::clamp(1.0 - entropy/8.0, minimumHeadroom, 1.0);
+    }
+
+    EffortScheduler::Allocation EffortScheduler::allocate(const Block& block) {
+        if (!isEnabled()) return {};
+
+        const double headroom = getHeadroom(block);
+        weightedHeadroomSeen += block.size()*headroom;
+        bytesSeen += block.size();
+        const double averageHeadroom = weightedHeadroomSeen / bytesSeen;
+
+        remainingBytes -= std::min(remainingBytes, block.size());
+        const double weight = block.size()*headroom;
+        const double share = weight / (weight + remainingBytes*averageHeadroom);
+
+        //a segment always gets something, since the evolver evaluates its initial population anyway
+        Allocation allocation;
+        if (hasEvaluationBudget) {
+            allocation.evaluations = std::max<size_t>(remainingEvaluations*share, 1);
+            remainingEvaluations -= std::min(remainingEvaluations, allocation.evaluations);
+        }
+        if (hasTimeBudget) {
+            allocation.time = std::max(Milliseconds((long long)(remainingTime.count()*share)), Milliseconds(1));
+            remainingTime -= std::min(remainingTime, allocation.time);
+        }
+        return allocation;
+    }
+
+    void EffortScheduler::registerUsage(const Allocation& allocation, const size_t evaluationsUsed, const Milliseconds timeUsed) {
+        //what's unused goes back to the pool, and an overrun (the evolver finishes its generation, or its initial population) is taken from it
+        if (hasEvaluationBudget) {
+            if (evaluationsUsed < allocation.evaluations) remainingEvaluations += allocation.evaluations - evaluationsUsed;
+            else remainingEvaluations -= std::min(remainingEvaluations, evaluationsUsed - allocation.evaluations);
+        }
+        if (hasTimeBudget) {
+            if (timeUsed < allocation.time) remainingTime += allocation.time - timeUsed;
+            else remainingTime -= std::min(remainingTime, timeUsed - allocation.time);
+        }
+    }
+
+} // GC
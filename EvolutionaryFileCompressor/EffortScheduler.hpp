@@ -0,0 +1,64 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_EFFORTSCHEDULER_HPP
+#define EVOCOM_EFFORTSCHEDULER_HPP
+
+#include "../names.hpp"
+#include "../Evolver/Evolver.hpp"
+#include <chrono>
+
+namespace GC {
+
+    /**
+     * Shares a budget for a whole file (fitness evaluations and/or milliseconds) between its segments,
+     * so that the time to compress a file is predictable.
+     *
+     * Segments are allocated in the order they're read. A segment's weight is its size times its headroom (1 - entropy/8, how compressible it looks),
+     * and it receives the fraction of the remaining budget that its weight is of the expected weight of the rest of the file,
+     * where the bytes not yet read are assumed to have the average headroom seen so far.
+     * The allocation is reserved straight away, and registerUsage gives back what a segment didn't use (eg because it stopped early),
+     * so in the sequential modes the segments after it get more. In the asynchronous mode all the segments are allocated before any finishes.
+     */
+    class EffortScheduler {
+    public:
+        using Milliseconds = std::chrono::milliseconds;
+
+        struct Allocation {
+            size_t evaluations = 0;        //0 when there's no evaluation budget
+            Milliseconds time{0};          //0 when there's no time budget
+
+            void applyTo(Evolver::EvolutionSettings& evoSettings) const;
+        };
+
+        static constexpr double minimumHeadroom = 0.05; //even random looking data might benefit from a transform
+
+    private:
+        const bool hasEvaluationBudget;
+        const bool hasTimeBudget;
+        size_t remainingEvaluations;
+        Milliseconds remainingTime;
+        size_t remainingBytes;
+
+        double weightedHeadroomSeen = 0; //sum of size*headroom of the segments allocated so far
+        size_t bytesSeen = 0;
+
+    public:
+        EffortScheduler(const size_t fileSize, const size_t evaluationBudget, const Milliseconds timeBudget);
+
+        bool isEnabled() const { return hasEvaluationBudget || hasTimeBudget; }
+
+        static double getHeadroom(const Block& block);
+
+        Allocation allocate(const Block& block);
+
+        void registerUsage(const Allocation& allocation, const size_t evaluationsUsed, const Milliseconds timeUsed);
+
+        size_t getRemainingEvaluations() const { return remainingEvaluations; }
+        Milliseconds getRemainingTime() const { return remainingTime; }
+    };
+
+} // GC
+
+#endif //EVOCOM_EFFORTSCHEDULER_HPP
@@ -9,7 +9,11 @@
 #include <fstream>
 #include "../../Utilities/utilities.hpp"
 #include "../../Utilities/Logger/Logger.hpp"
+#include "../../Random/RandomGenerator.hpp"
+#include "../../Evolver/Recipe/PackedTList.hpp"
 #include <sstream>
+#include <thread>
+#include <limits>
 
 namespace GC {
 
@@ -44,7 +48,41 @@ namespace GC {
 
         size_t minTransformAmount, maxTransformAmount;
 
+        size_t stagnationLimit;           //generations without improvement after which a segment stops evolving, 0 to disable
+        double targetFitness;             //a segment stops evolving when a recipe is at least this good, 0 to disable
+        size_t segmentTimeBudgetInMilliseconds; //0 to disable
+
+        size_t fileEvaluationBudget;           //fitness evaluations shared by all the segments of a file, 0 to disable
+        size_t fileTimeBudgetInMilliseconds;   //evolution time shared by all the segments of a file, 0 to disable
+
         bool async;
+        size_t evaluationThreads = 1; //threads used to evaluate a generation, the asynchronous mode already has a thread per segment
+        RandomGenerator::Seed seed;   //each segment evolves with a seed derived from this one, so runs with the same seed give the same output
+
+        size_t islandAmount;          //populations evolving side by side for each segment, each on its own thread, 1 to disable
+        size_t migrationInterval;     //generations between the exchanges of individuals between the islands
+        size_t migrantAmount;         //individuals sent by an island at each exchange
+
+        bool warmStart;                   //a segment's population starts from the elite of the most similar segment evolved before it
+        size_t warmStartCheckGeneration;  //when the elite isn't improved by more than warmStartTolerance after this many generations, the segment stops, 0 to disable
+        double warmStartTolerance;
+
+        FileName surrogateModelFile;      //a model made by a data collection run, empty when there's none
+        double surrogateMargin;           //a child whose estimate is worse than the best fitness by more than this isn't evaluated
+        FileName surrogateTrainingFile;   //in the data collection mode, where the model trained from the evaluations is written, empty to not train
+
+        //which engine finds the recipe of a segment: the evolution, the beam search, or the beam search for the segments of at most beamSegmentLimit bytes
+        enum Engine {EvolutionEngine, BeamSearchEngine, AutomaticEngine} engine;
+        size_t beamSegmentLimit;
+        size_t beamWidth;                 //transform chains kept at each level of the beam search
+        size_t beamDepth;                 //levels of the beam search, capped by maxTransformAmount
+
+        size_t lowFidelitySampleSize;     //children are first scored on this many bytes, and only the best promotedProportion are evaluated on the whole sample, 0 to disable
+        double promotedProportion;
+        size_t championSampleSize;        //the elite of a segment is compared again on this many bytes of it to pick the recipe, 0 to disable
+
+        FileName recipeCacheFile;     //empty when there's no recipe cache
+        size_t recipeCacheCapacity;
 
 
 
@@ -132,6 +170,19 @@ namespace GC {
             return def;
         }
 
+        //when the value isn't a number that fits in a seed, the error is reported and a fresh seed is used instead
+        RandomGenerator::Seed getSeedFromDict(const Dictionary& dict, const Param& param) {
+            if (containsParam(dict, param)) {
+                const std::string valueAsString = dict.at(param);
+                std::istringstream valueStream(valueAsString);
+                RandomGenerator::Seed value;
+                const bool isAllDigits = !valueAsString.empty() && std::all_of(valueAsString.begin(), valueAsString.end(), ::isdigit);
+                if (isAllDigits && valueStream >> value) return value;
+                LOG_NOSPACES("The value \"", valueAsString, "\" of the parameter ", param, " is not a valid seed, a fresh one is used instead");
+            }
+            return RandomGenerator::getFreshSeed();
+        }
+
         static void toUpper(std::string& s) {
             std::transform(s.begin(), s.end(), s.begin(), std::ptr_fun<int, int>(std::toupper));
         }
@@ -170,14 +221,48 @@ namespace GC {
                 usesAnnealing = getBoolFromDict(dict, "USES_ANNEALING", true);
                 eliteSize = getIntFromDict(dict, "ELITE_SIZE", 3);
 
-                tournamentSelectionSize = getIntFromDict(dict, "TOURNAMENT_SELECTION_SIZE", 1);
+                tournamentSelectionSize = getIntFromDict(dict, "TOURNAMENT_SELECTION_SIZE", 6);
                 excessiveMutationThreshold = getDoubleFromDict(dict, "EXCESSIVE_MUTATION_THRESHOLD", 0.75);
                 unstabilityThreshold = getDoubleFromDict(dict, "UNSTABILITY_THRESHOLD", 0.4);
 
                 minTransformAmount = getIntFromDict(dict, "MIN_TRANSFORM_AMOUNT", 0);
-                maxTransformAmount = getIntFromDict(dict, "MAX_TRANSFORM_AMOUNT", 6);
+                maxTransformAmount = std::min<size_t>(getIntFromDict(dict, "MAX_TRANSFORM_AMOUNT", 6), PackedTList::capacity); //recipes can't hold more
+
+                stagnationLimit = getIntFromDict(dict, "STAGNATION_LIMIT", 0);
+                targetFitness = getDoubleFromDict(dict, "TARGET_FITNESS", 0);
+                segmentTimeBudgetInMilliseconds = getIntFromDict(dict, "SEGMENT_TIME_BUDGET_MS", 0);
+                fileEvaluationBudget = getIntFromDict(dict, "FILE_EVALUATION_BUDGET", 0);
+                fileTimeBudgetInMilliseconds = getIntFromDict(dict, "FILE_TIME_BUDGET_MS", 0);
 
                 async = (mode == CompressionDataCollection) ? false : getBoolFromDict(dict, "ASYNC", true);
+                const size_t availableThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+                evaluationThreads = std::max(getIntFromDict(dict, "EVALUATION_THREADS", async ? 1 : availableThreads), 1);
+                seed = getSeedFromDict(dict, "SEED");
+
+                islandAmount = std::max(getIntFromDict(dict, "ISLANDS", 1), 1);
+                migrationInterval = std::max(getIntFromDict(dict, "MIGRATION_INTERVAL", 5), 1);
+                migrantAmount = getIntFromDict(dict, "MIGRANTS", 2);
+
+                //it changes the output, so it's opt in. In the asynchronous mode which segments have finished depends on timing
+                warmStart = getBoolFromDict(dict, "WARM_START", false);
+                warmStartCheckGeneration = getIntFromDict(dict, "WARM_START_CHECK_GENERATION", 3);
+                warmStartTolerance = getDoubleFromDict(dict, "WARM_START_TOLERANCE", 0.005);
+
+                surrogateModelFile = getStringFromDict(dict, "SURROGATE_MODEL", "");
+                surrogateMargin = getDoubleFromDict(dict, "SURROGATE_MARGIN", 0.5);
+                surrogateTrainingFile = getStringFromDict(dict, "SURROGATE_TRAINING_FILE", "");
+
+                engine = getEnumFromDict(dict, "ENGINE", {{"evolver", EvolutionEngine}, {"beam", BeamSearchEngine}, {"auto", AutomaticEngine}}, EvolutionEngine);
+                beamSegmentLimit = getIntFromDict(dict, "BEAM_SEGMENT_LIMIT", 1024);
+                beamWidth = std::max(getIntFromDict(dict, "BEAM_WIDTH", 2), 1);
+                beamDepth = getIntFromDict(dict, "BEAM_DEPTH", 3);
+
+                lowFidelitySampleSize = getIntFromDict(dict, "LOW_FIDELITY_SAMPLE", 0);
+                promotedProportion = getDoubleFromDict(dict, "PROMOTED_PROPORTION", 0.25);
+                championSampleSize = getIntFromDict(dict, "CHAMPION_SAMPLE", 0);
+
+                recipeCacheFile = getStringFromDict(dict, "RECIPE_CACHE", "");
+                recipeCacheCapacity = getIntFromDict(dict, "RECIPE_CACHE_CAPACITY", 64*1024);
             }
             else if (mode == Decompress) {
                 inputFile = getStringFromDict(dict, "FILE", "input");
@@ -221,6 +306,17 @@ namespace GC {
             }
         }
 
+        /**
+         * @return the size up to which the segments use the beam search instead of the evolution
+         */
+        size_t getBeamSearchMaxSegmentSize() const {
+            switch (engine) {
+                case BeamSearchEngine: return std::numeric_limits<size_t>::max();
+                case AutomaticEngine: return beamSegmentLimit;
+                default: return 0;
+            }
+        }
+
         std::string to_string() const {
             Logger logger;
             log(logger);
@@ -261,8 +357,35 @@ namespace GC {
                 logger.addVar("tournamentSelectionSize", tournamentSelectionSize);
                 logger.addVar("excessiveMutationThreshold", excessiveMutationThreshold);
                 logger.addVar("asynchronous", async);
+                logger.addVar("evaluationThreads", evaluationThreads);
+                logger.addVar("seed", seed);
+                logger.addVar("islandAmount", islandAmount);
+                logger.addVar("migrationInterval", migrationInterval);
+                logger.addVar("migrantAmount", migrantAmount);
+                logger.addVar("warmStart", warmStart);
+                logger.addVar("warmStartCheckGeneration", warmStartCheckGeneration);
+                logger.addVar("warmStartTolerance", warmStartTolerance);
+                logger.addVar("surrogateModelFile", surrogateModelFile);
+                logger.addVar("surrogateMargin", surrogateMargin);
+                logger.addVar("surrogateTrainingFile", surrogateTrainingFile);
+                const std::map<Engine, std::string> enginesAsStrings{{EvolutionEngine, "evolver"}, {BeamSearchEngine, "beam"}, {AutomaticEngine, "auto"}};
+                logger.addVar("engine", enginesAsStrings.at(engine));
+                if (engine != EvolutionEngine) {
+                    logger.addVar("beamWidth", beamWidth);
+                    logger.addVar("beamDepth", beamDepth);
+                }
+                if (engine == AutomaticEngine) logger.addVar("beamSegmentLimit", beamSegmentLimit);
+                logger.addVar("lowFidelitySampleSize", lowFidelitySampleSize);
+                if (lowFidelitySampleSize > 0) logger.addVar("promotedProportion", promotedProportion);
+                logger.addVar("championSampleSize", championSampleSize);
+                logger.addVar("recipeCacheFile", recipeCacheFile);
                 logger.addVar("minTransformAmount", minTransformAmount);
                 logger.addVar("maxTransformAmount", maxTransformAmount);
+                logger.addVar("stagnationLimit", stagnationLimit);
+                logger.addVar("targetFitness", targetFitness);
+                logger.addVar("segmentTimeBudgetInMilliseconds", segmentTimeBudgetInMilliseconds);
+                logger.addVar("fileEvaluationBudget", fileEvaluationBudget);
+                logger.addVar("fileTimeBudgetInMilliseconds", fileTimeBudgetInMilliseconds);
             }
             logger.endObject(); //ends settings
         }
@@ -3,6 +3,8 @@
 //
 
 #include "EvolutionaryFileCompressor.hpp"
+#include "RecipePipeline.hpp"
+#include "TilePipeline.hpp"
 #include <vector>
 #include "../Utilities/StreamingClusterer/StreamingClusterer.hpp"
 #include "../AbstractBit/FileBitWriter/FileBitWriter.hpp"
@@ -40,25 +42,36 @@ namespace GC {
 
     /**
      * This function is used to generate the data about what transformations and compressions worked best for a given block report
+     * When settings.surrogateTrainingFile is set, a surrogate model is also trained from all the evaluations, and saved there
      * @param settings
      */
     void EvolutionaryFileCompressor::generateCompressionData(const EvoComSettings& settings, Logger& logger) {
         settings.log(logger);
+        std::unique_ptr<SurrogateModel::Trainer> surrogateTrainer;
+        if (!settings.surrogateTrainingFile.empty()) surrogateTrainer = std::make_unique<SurrogateModel::Trainer>();
+
         logger.beginList("parsingOfFiles");
         auto parseFile = [&](const FileName& file) {
             //LOG("Parsing ", file);
             logger.beginUnnamedObject();
-            double timeInMilliseconds = timeFunction([&](){ processSingleFileForCompressionDataCollection(file, settings, logger);});
+            double timeInMilliseconds = timeFunction([&](){ processSingleFileForCompressionDataCollection(file, settings, logger, surrogateTrainer.get());});
             logger.addVar("timeForFile", timeInMilliseconds);
             logger.endObject();
         };
 
         std::for_each(settings.testSet.begin(), settings.testSet.end(), parseFile);
         logger.endList(); //ends parsing of file
+
+        if (surrogateTrainer) {
+            logger.addVar("surrogateTrainingSamples", surrogateTrainer->getSampleAmount());
+            if (!surrogateTrainer->fit().save(settings.surrogateTrainingFile))
+                LOG("ERROR: could not save the surrogate model to", settings.surrogateTrainingFile);
+        }
     }
 
     void EvolutionaryFileCompressor::processSingleFileForCompressionDataCollection(
-            const EvolutionaryFileCompressor::FileName &file, const EvoComSettings &settings, Logger &logger) {
+            const EvolutionaryFileCompressor::FileName &file, const EvoComSettings &settings, Logger &logger,
+            SurrogateModel::Trainer* surrogateTrainer) {
 
         logger.addVar("fileName", file);
         const size_t originalFileSize = getFileSize(file);
@@ -74,7 +87,7 @@ namespace GC {
         if (!inStream ) {logger.addVar("Error_FileUnopenable", true);  logger.endObject(); return;}
 
         //ignores async settings
-        compressToStreamsSequentially_DataCollection(reader, writer, originalFileSize, settings, logger);
+        compressToStreamsSequentially_DataCollection(reader, writer, originalFileSize, settings, logger, surrogateTrainer);
 
         logger.addVar("FinalFileSizeInBits", writer.getAmountOfBytes());
     }
@@ -83,14 +96,31 @@ namespace GC {
 
     void EvolutionaryFileCompressor::compressToStreamsSequentially(AbstractBitReader& reader, AbstractBitWriter& writer, const size_t originalFileSize, const EvoComSettings& settings) {
         bool isFirstSegment = true;
-        Evolver::EvolutionSettings evoSettings(settings);
+        const Evolver::EvolutionSettings evoSettings(settings);
+        std::unique_ptr<RecipeCache> recipeCache = openRecipeCache(settings);
+        EffortScheduler scheduler = makeEffortScheduler(originalFileSize, settings);
+        std::unique_ptr<WarmStartBoard> warmStartBoard = makeWarmStartBoard(settings);
+        std::unique_ptr<SurrogateModel> surrogateModel = loadSurrogateModel(settings);
+        writeFileHeader(writer);
+        RecipeTable recipeTable;
+        size_t segmentIndex = 0;
         auto compressBlock = [&](const Block& block) {
             LOG("Received a block of size", block.size());
-            Recipe bestIndividual = evolveBestIndividualForBlock(block, evoSettings);
-            LOG("For this block, the best individual is", bestIndividual.to_string());
+            Evolver::EvolutionSettings segmentSettings = evoSettings;
+            segmentSettings.seed = RandomGenerator::deriveSeed(settings.seed, segmentIndex++);
+            const EffortScheduler::Allocation allocation = scheduler.allocate(block);
+            allocation.applyTo(segmentSettings);
+
+            Recipe bestIndividual;
+            Evaluator::CacheStatistics cacheStatistics;
+            const double timeInMillisecondsForEvolution = timeFunction([&](){
+                bestIndividual = evolveBestIndividualForBlock(block, segmentSettings, cacheStatistics, recipeCache.get(), warmStartBoard.get(), surrogateModel.get());
+            });
+            scheduler.registerUsage(allocation, cacheStatistics.misses, EffortScheduler::Milliseconds((long long)timeInMillisecondsForEvolution));
+            LOG("For this block, the best individual is", bestIndividual.to_string(), cacheStatistics.to_string());
             if (!isFirstSegment) writer.pushBit(true);  //signifies that the segment before had a segment after it
             isFirstSegment = false;
-            encodeIndividual(bestIndividual, writer);
+            encodeRecipeReference(bestIndividual, recipeTable, writer);
             compressBlockUsingRecipe(bestIndividual, block, writer);
 
         };
@@ -100,6 +130,7 @@ namespace GC {
         else
             processFileAsFixedSegments(reader, compressBlock, originalFileSize, settings);
 
+        if (recipeCache) LOG(recipeCache->getStatistics().to_string());
         writer.pushBit(false);
         writer.writeLastByte();
     }
@@ -108,27 +139,49 @@ namespace GC {
                                                                                   BitCounter &writer,
                                                                                   const size_t originalFileSize,
                                                                                   const EvoComSettings &settings,
-                                                                                  Logger &logger) {
+                                                                                  Logger &logger,
+                                                                                  SurrogateModel::Trainer* surrogateTrainer) {
         bool isFirstSegment = true;
-        Evolver::EvolutionSettings evoSettings(settings);
+        const Evolver::EvolutionSettings evoSettings(settings);
+        EffortScheduler scheduler = makeEffortScheduler(originalFileSize, settings);
+        std::unique_ptr<WarmStartBoard> warmStartBoard = makeWarmStartBoard(settings);
+        std::unique_ptr<SurrogateModel> surrogateModel = loadSurrogateModel(settings);
+        writeFileHeader(writer);
+        RecipeTable recipeTable;
 
         size_t compressedSoFar = 0;
+        size_t segmentIndex = 0;
         auto compressBlock = [&](const Block& block) {
 #if LOG_PROGRESS
             compressedSoFar += block.size();
             LOG("Progress:", (double) ((double)compressedSoFar*100)/originalFileSize, "%");
 #endif
+            Evolver::EvolutionSettings segmentSettings = evoSettings;
+            segmentSettings.seed = RandomGenerator::deriveSeed(settings.seed, segmentIndex++);
+            const EffortScheduler::Allocation allocation = scheduler.allocate(block);
+            allocation.applyTo(segmentSettings);
+
             Recipe bestIndividual;
+            Evaluator::CacheStatistics cacheStatistics;
             const size_t timeInMillisecondsForEvolution = timeFunction([&](){
-                bestIndividual = evolveBestIndividualForBlock(block, evoSettings);
+                bestIndividual = evolveBestIndividualForBlock(block, segmentSettings, cacheStatistics, nullptr, warmStartBoard.get(),
+                                                              surrogateModel.get(), surrogateTrainer);
             });
+            scheduler.registerUsage(allocation, cacheStatistics.misses, EffortScheduler::Milliseconds(timeInMillisecondsForEvolution));
             logger.beginUnnamedObject();
             logger.addVar("EvolutionTime", timeInMillisecondsForEvolution);
+            if (scheduler.isEnabled()) {
+                logger.addVar("AllocatedEvaluations", allocation.evaluations);
+                logger.addVar("AllocatedTime", (size_t)allocation.time.count());
+            }
+            logger.addVar("FitnessEvaluations", cacheStatistics.misses);
+            if (surrogateModel) logger.addVar("ScreenedEvaluations", cacheStatistics.screened);
+            logger.addVar("FitnessCacheHitRate", cacheStatistics.getHitRate());
 
             //LOG("Generated the best individual, now encoding...");
             if (!isFirstSegment) writer.pushBit(true);  //signifies that the segment before had a segment after it
             isFirstSegment = false;
-            encodeIndividual(bestIndividual, writer);
+            encodeRecipeReference(bestIndividual, recipeTable, writer);
             compressBlockUsingRecipe_DataCollection(bestIndividual, block, writer, logger);
         };
 
@@ -147,17 +200,32 @@ namespace GC {
         using JobQueue = std::queue<Job>;
 
         JobQueue jobQueue;
-        Evolver::EvolutionSettings evoSettings(settings);
+        const Evolver::EvolutionSettings evoSettings(settings);
+        std::unique_ptr<RecipeCache> recipeCache = openRecipeCache(settings); //outlives the jobs, which are all waited for below
+        EffortScheduler scheduler = makeEffortScheduler(originalFileSize, settings); //the segments all start together, so nothing is redistributed
+        std::unique_ptr<WarmStartBoard> warmStartBoard = makeWarmStartBoard(settings); //also outlives the jobs
+        std::unique_ptr<SurrogateModel> surrogateModel = loadSurrogateModel(settings); //same
 
+        size_t segmentIndex = 0;
         auto passBlockToJobQueue = [&](const Block& block) {
             //LOG("Received the block (size", block.size(), "), passing it to the queue");
+            Evolver::EvolutionSettings segmentSettings = evoSettings; //copied into the job
+            segmentSettings.seed = RandomGenerator::deriveSeed(settings.seed, segmentIndex++);
+            scheduler.allocate(block).applyTo(segmentSettings);
             jobQueue.emplace(block, std::async(
                     std::launch::async,
-                    &EvolutionaryFileCompressor::evolveBestIndividualForBlock,
+                    static_cast<Recipe(*)(const Block&, const Evolver::EvolutionSettings&, RecipeCache*, WarmStartBoard*,
+                                          const SurrogateModel*, SurrogateModel::Trainer*)>(&EvolutionaryFileCompressor::evolveBestIndividualForBlock),
                     block,
-                    evoSettings));
+                    segmentSettings,
+                    recipeCache.get(),
+                    warmStartBoard.get(),
+                    surrogateModel.get(),
+                    nullptr));
         };
 
+        writeFileHeader(writer);
+        RecipeTable recipeTable;
         bool isFirstSegment = true;
         //size_t processedSoFar = 0;
         auto compressBlock = [&](const Block& block, const Recipe& recipe) {
@@ -166,7 +234,7 @@ namespace GC {
             //LOG_NOSPACES("(Progress ", progress, "%) Received the block (size ", block.size(), "), and the recipe ", recipe.to_string());
             if (!isFirstSegment) writer.pushBit(true);  //signifies that the segment before had a segment after it
             isFirstSegment = false;
-            encodeIndividual(recipe, writer);
+            encodeRecipeReference(recipe, recipeTable, writer);
             compressBlockUsingRecipe(recipe, block, writer);
         };
 
@@ -190,6 +258,7 @@ namespace GC {
         }
 
         LOG("all done!");
+        if (recipeCache) LOG(recipeCache->getStatistics().to_string());
 
         writer.pushBit(false);
         writer.writeLastByte();
@@ -222,12 +291,61 @@ namespace GC {
 
 
 
+    /**
+     * Applies the transforms of the recipe, alternating between the two buffers so that the original block is never copied.
+     * On blocks larger than a tile, runs of several local transforms are streamed through the TilePipeline instead,
+     * so that their intermediate results are never materialised.
+     * @return a reference to either the original block (if there are no transforms), or one of the buffers
+     */
+    const Block& EvolutionaryFileCompressor::applyRecipeTransforms(const Recipe &recipe, const Block &block, TransformBuffers& buffers) {
+        std::array<TCode, Recipe::TList::capacity> tCodes;
+        const size_t amount = recipe.tList.unpackInto(tCodes.data());
+        const Block* current = &block;
+        for (size_t i=0;i<amount;) {
+            Block* target = (current == &buffers.front) ? &buffers.back : &buffers.front;
+            const size_t runEnd = TilePipeline::streamableRunEnd(tCodes.data(), amount, i);
+            if (runEnd-i >= 2 && current->size() > TilePipeline::defaultTileSize) {
+                TilePipeline::apply(tCodes.data()+i, runEnd-i, *current, *target);
+                i = runEnd;
+            }
+            else {
+                applyTransformCode(tCodes[i], *current, *target);
+                i++;
+            }
+            current = target;
+        }
+        return *current;
+    }
+
+    /**
+     * Like applyRecipeTransforms, but starts from the longest prefix of the recipe whose result is in the cache,
+     * and stores the results of the transforms that it applies.
+     */
+    const Block& EvolutionaryFileCompressor::applyRecipeTransforms(const Recipe &recipe, const Block &block, TransformBuffers& buffers,
+                                                                   TransformPrefixCache& prefixCache) {
+        const size_t cachedLength = prefixCache.copyLongestPrefix(recipe.tList, buffers.front);
+        const Block* current = (cachedLength > 0) ? &buffers.front : &block;
+        for (size_t i=cachedLength;i<recipe.tList.size();i++) {
+            Block* target = (current == &buffers.front) ? &buffers.back : &buffers.front;
+            applyTransformCode(recipe.tList[i], *current, *target);
+            prefixCache.registerAppliedTransform();
+            current = target;
+            prefixCache.store(recipe.tList, i+1, *current);
+        }
+        return *current;
+    }
+
     void EvolutionaryFileCompressor::compressBlockUsingRecipe(const Recipe &individual, const Block &block, AbstractBitWriter& writer) {
+        TransformBuffers buffers;
+        compressBlockUsingRecipe(individual, block, writer, buffers);
+    }
+
+    void EvolutionaryFileCompressor::compressBlockUsingRecipe(const Recipe &individual, const Block &block, AbstractBitWriter& writer, TransformBuffers& buffers) {
         ////LOG("Applying individual ", individual.to_string());
-        Block toBeProcessed = block;
-        for (auto tCode : individual.tList)
-            applyTransformCode(tCode, toBeProcessed);
-        applyCompressionCode(individual.cCode, toBeProcessed, writer);
+        if (const SpecialisedPipeline* pipeline = findSpecialisedPipeline(individual))
+            return pipeline->compress(block, writer, buffers);
+        const Block& transformed = applyRecipeTransforms(individual, block, buffers);
+        applyCompressionCode(individual.cCode, transformed, writer);
     }
 
     void logBlockAndTransform(const Block& block, const TCode operation, Logger& logger) {
@@ -276,17 +394,69 @@ namespace GC {
     }
 
 
-    void EvolutionaryFileCompressor::encodeIndividual(const Recipe& individual, AbstractBitWriter& writer){
-        auto encodeTransform = [&](const TCode tc) {
-            writer.writeAmountOfBits(tc, bitSizeForCompressionCode);
-        };
-        auto encodeCompression = [&](const CCode cc) {
-            writer.writeAmountOfBits(cc, bitSizeForCompressionCode);
-        };
+    void EvolutionaryFileCompressor::writeFileHeader(AbstractBitWriter& writer) {
+        writer.writeAmountOfBits(versionedFileMarker, bitsForAmountOfTransforms);
+        writer.writeAmountOfBits(currentFormatVersion, bitsForFormatVersion);
+    }
+
+    void EvolutionaryFileCompressor::writeEscapedCode(const size_t code, AbstractBitWriter& writer) {
+        if (code < escapeCode)
+            writer.writeAmountOfBits(code, bitSizeForTransformCode);
+        else {
+            writer.writeAmountOfBits(escapeCode, bitSizeForTransformCode);
+            writer.writeSmallAmount(code-escapeCode);
+        }
+    }
+
+    size_t EvolutionaryFileCompressor::readEscapedCode(AbstractBitReader& reader) {
+        const size_t code = reader.readAmountOfBits(bitSizeForTransformCode);
+        return (code < escapeCode) ? code : escapeCode+reader.readSmallAmount();
+    }
+
+    void EvolutionaryFileCompressor::encodeTransformCode(const TransformCode tc, AbstractBitWriter& writer) {
+        auto parameterised = std::find_if(parameterisedTCodes.begin(), parameterisedTCodes.end(),
+                                          [&](const ParameterisedTCode& p) {return p.tCode == tc;});
+        if (parameterised == parameterisedTCodes.end()) {
+            writeEscapedCode(tc, writer);
+            return;
+        }
+        writeEscapedCode(parameterised->family, writer);
+        writer.writeSmallAmount(parameterised->parameter);
+    }
+
+    std::optional<EvolutionaryFileCompressor::TransformCode> EvolutionaryFileCompressor::decodeTransformCode(AbstractBitReader& reader, const size_t formatVersion) {
+        if (formatVersion < firstVersionWithEscapedCodes)
+            return static_cast<TCode>(reader.readAmountOfBits(bitSizeForTransformCode));
+
+        const TCode code = static_cast<TCode>(readEscapedCode(reader));
+        auto isFamily = [&](const ParameterisedTCode& p) {return p.family == code;};
+        if (std::none_of(parameterisedTCodes.begin(), parameterisedTCodes.end(), isFamily))
+            return code;
+
+        const size_t parameter = reader.readSmallAmount();
+        auto parameterised = std::find_if(parameterisedTCodes.begin(), parameterisedTCodes.end(),
+                                          [&](const ParameterisedTCode& p) {return p.family == code && p.parameter == parameter;});
+        if (parameterised == parameterisedTCodes.end()) {
+            LOG("ERROR: the transform", Recipe::TCode_as_string(code), "has no variant with parameter", parameter);
+            return std::nullopt;
+        }
+        return parameterised->tCode;
+    }
+
+    EvolutionaryFileCompressor::CompressionCode EvolutionaryFileCompressor::decodeCompressionCode(AbstractBitReader& reader, const size_t formatVersion) {
+        if (formatVersion < firstVersionWithEscapedCodes)
+            return static_cast<CCode>(reader.readAmountOfBits(bitSizeForCompressionCode));
+        return static_cast<CCode>(readEscapedCode(reader));
+    }
 
+    /**
+     * Always writes in the current format version
+     */
+    void EvolutionaryFileCompressor::encodeIndividual(const Recipe& individual, AbstractBitWriter& writer){
+        ASSERT(individual.tList.size() < versionedFileMarker);
         writer.writeAmountOfBits(individual.tList.size(), bitsForAmountOfTransforms);
-        for (const auto tCode: individual.tList) encodeTransform(tCode);
-        encodeCompression(individual.cCode);
+        for (const auto tCode: individual.tList) encodeTransformCode(tCode, writer);
+        writeEscapedCode(individual.cCode, writer);
     }
 
 
@@ -299,10 +469,33 @@ namespace GC {
         FileBitReader reader(inStream);
         FileBitWriter writer(outStream);
 
-        auto decodeAndWriteOnFile = [&]() {
-            const Recipe individual = decodeIndividual(reader);
-            const Block decodedBlock = decodeUsingIndividual(individual, reader);
+        decompressFromStreams(reader, writer);
+    }
+
+    void EvolutionaryFileCompressor::decompressFromStreams(AbstractBitReader& reader, AbstractBitWriter& writer) {
+        //the first nibble is either the marker of a versioned file, or the amount of transforms of the first recipe in a legacy file
+        const size_t firstNibble = reader.readAmountOfBits(bitsForAmountOfTransforms);
+        const bool isVersioned = firstNibble == versionedFileMarker;
+        const size_t formatVersion = isVersioned ? reader.readAmountOfBits(bitsForFormatVersion) : legacyFormatVersion;
+        if (formatVersion > currentFormatVersion) {
+            LOG("ERROR: the file has format version", formatVersion, ", but the latest supported one is", currentFormatVersion);
+            return;
+        }
+
+        bool isFirstSegment = true;
+        RecipeTable recipeTable;
+        auto decodeRecipe = [&]() -> std::optional<Recipe> {
+            if (!isVersioned && isFirstSegment) return decodeIndividual(firstNibble, reader, formatVersion);
+            if (formatVersion >= firstVersionWithRecipeTable) return decodeRecipeReference(recipeTable, reader, formatVersion);
+            return decodeIndividual(reader, formatVersion);
+        };
+        auto decodeAndWriteOnFile = [&]() -> bool {
+            const std::optional<Recipe> individual = decodeRecipe();
+            if (!individual) return false;
+            isFirstSegment = false;
+            const Block decodedBlock = decodeUsingIndividual(*individual, reader);
             writeBlock(decodedBlock, writer);
+            return true;
         };
 
         //LOG("starting the decoding of blocks");
@@ -312,29 +505,81 @@ namespace GC {
             return morePresent;
         };
         do {
-            decodeAndWriteOnFile();
+            if (!decodeAndWriteOnFile()) {
+                LOG("ERROR: the file is corrupted or was written by an incompatible version, the decompression stops here");
+                break;
+            }
         } while (thereAreMoreSegments()); //if there is a bit following a segment, there is another segment to be decoded
 
         writer.writeLastByte();
 
     }
 
-    Recipe EvolutionaryFileCompressor::decodeIndividual(AbstractBitReader& reader) {
-        std::vector<TCode> tList;
-        auto addTCode = [&](){
-            tList.push_back(static_cast<TCode>(reader.readAmountOfBits(bitSizeForTransformCode)));
-        };
+    void EvolutionaryFileCompressor::encodeRecipeReference(const Recipe& recipe, RecipeTable& table, AbstractBitWriter& writer) {
+        if (!table.recipes.empty()) {
+            const bool isSameAsPrevious = table.recipes[table.previousIndex] == recipe;
+            writer.pushBit(isSameAsPrevious);
+            if (isSameAsPrevious) return;
+        }
 
-        auto extractCCode = [&]() -> CCode{
-            return static_cast<CCode>(reader.readAmountOfBits(bitSizeForCompressionCode));
-        };
+        auto found = table.indexes.find(recipe);
+        const bool isNew = found == table.indexes.end();
+        if (table.recipes.size() > 1) writer.pushBit(isNew);
+        if (isNew) {
+            encodeIndividual(recipe, writer);
+            table.previousIndex = table.recipes.size();
+            table.indexes.emplace(recipe, table.previousIndex);
+            table.recipes.push_back(recipe);
+        }
+        else {
+            writer.writeAmountOfBits(found->second, ceil_log2(table.recipes.size()));
+            table.previousIndex = found->second;
+        }
+    }
+
+    std::optional<Recipe> EvolutionaryFileCompressor::decodeRecipeReference(RecipeTable& table, AbstractBitReader& reader, const size_t formatVersion) {
+        if (!table.recipes.empty()) {
+            const bool isSameAsPrevious = reader.readBit();
+            if (isSameAsPrevious) return table.recipes[table.previousIndex];
+        }
+
+        const bool isNew = table.recipes.size() <= 1 || reader.readBit();
+        if (isNew) {
+            const std::optional<Recipe> recipe = decodeIndividual(reader, formatVersion);
+            if (!recipe) return std::nullopt;
+            table.previousIndex = table.recipes.size();
+            table.recipes.push_back(*recipe);
+        }
+        else {
+            const size_t index = reader.readAmountOfBits(ceil_log2(table.recipes.size()));
+            ASSERT(index < table.recipes.size());
+            table.previousIndex = index;
+        }
+        return table.recipes[table.previousIndex];
+    }
+
+    std::optional<Recipe> EvolutionaryFileCompressor::decodeIndividual(AbstractBitReader& reader, const size_t formatVersion) {
+        const size_t amountOfTransforms = reader.readAmountOfBits(bitsForAmountOfTransforms);
+        return decodeIndividual(amountOfTransforms, reader, formatVersion);
+    }
 
-        size_t amountOfTransforms = reader.readAmountOfBits(bitsForAmountOfTransforms);
-        repeat(amountOfTransforms, addTCode);
-        return {tList, extractCCode()};
+    std::optional<Recipe> EvolutionaryFileCompressor::decodeIndividual(const size_t amountOfTransforms, AbstractBitReader& reader, const size_t formatVersion) {
+        if (amountOfTransforms > Recipe::TList::capacity) { //only possible in a legacy file, the versioned ones never write more
+            LOG("ERROR: the file has a recipe with", amountOfTransforms, "transforms, but at most", Recipe::TList::capacity, "are supported");
+            return std::nullopt;
+        }
+        TList tList;
+        for (size_t i=0;i<amountOfTransforms;i++) {
+            const std::optional<TransformCode> tCode = decodeTransformCode(reader, formatVersion);
+            if (!tCode) return std::nullopt;
+            tList.push_back(*tCode);
+        }
+        return Recipe(tList, decodeCompressionCode(reader, formatVersion));
     }
 
     Block EvolutionaryFileCompressor::decodeUsingIndividual(const Recipe& individual, AbstractBitReader& reader) {
+        if (const SpecialisedPipeline* pipeline = findSpecialisedPipeline(individual))
+            return pipeline->decompress(reader);
         Block transformedBlock = undoCompressionCode(individual.cCode, reader);
         std::for_each(individual.tList.rbegin(), individual.tList.rend(), [&](auto tc){
             undoTransformCode(tc, transformedBlock);});
@@ -349,12 +594,15 @@ namespace GC {
     }
 
 
-    EvolutionaryFileCompressor::Fitness EvolutionaryFileCompressor::compressionRatioForIndividualOnBlock(const Recipe& individual, const Block& block) {
+    EvolutionaryFileCompressor::Fitness EvolutionaryFileCompressor::compressionRatioForIndividualOnBlock(const Recipe& individual, const Block& block,
+                                                                                                       TransformPrefixCache& prefixCache) {
         size_t originalSize = block.size()*8;
 
+        thread_local TransformBuffers evaluationBuffers; //reused across evaluations, so in the steady state the transforms don't allocate
+
         BitCounter counterWriter;
         encodeIndividual(individual, counterWriter);
-        compressBlockUsingRecipe(individual, block, counterWriter);
+        applyCompressionCode(individual.cCode, applyRecipeTransforms(individual, block, evaluationBuffers, prefixCache), counterWriter);
         size_t compressedSize = counterWriter.getAmountOfBits();
         //a compressed block is a sequence of bits, not necessarly in multiples of 8
                 ASSERT_NOT_EQUALS(compressedSize, 0); //would be impossible
@@ -372,35 +620,153 @@ namespace GC {
         return malusMultiplier*oldFitness;
     }
 
-    double EvolutionaryFileCompressor::getAdjustedFitnessOfIndividual(const Recipe& recipe, const Block& block) {
-        const double originalFitness = compressionRatioForIndividualOnBlock(recipe, block);
+    double EvolutionaryFileCompressor::getAdjustedFitnessOfIndividual(const Recipe& recipe, const Block& block, TransformPrefixCache& prefixCache) {
+        const double originalFitness = compressionRatioForIndividualOnBlock(recipe, block, prefixCache);
         return adjustFitness(originalFitness, recipe);
     }
 
-    Block EvolutionaryFileCompressor::getBlockSample(const Block& block) {
-        constexpr size_t sampleSize = 1024; //1 KB
+    Block EvolutionaryFileCompressor::getBlockSample(const Block& block, const size_t sampleSize) {
         const size_t blockSampleLength = std::min(sampleSize, block.size());
         const Block blockSample(block.begin(), block.begin()+blockSampleLength);
         return blockSample;
     }
 
 
-    Recipe EvolutionaryFileCompressor::evolveBestIndividualForBlock(const Block & block, const Evolver::EvolutionSettings& evoSettings) {
+    Recipe EvolutionaryFileCompressor::evolveBestIndividualForBlock(const Block & block, const Evolver::EvolutionSettings& evoSettings,
+                                                                    RecipeCache* recipeCache, WarmStartBoard* warmStartBoard,
+                                                                    const SurrogateModel* surrogateModel, SurrogateModel::Trainer* surrogateTrainer) {
+        Evaluator::CacheStatistics cacheStatistics;
+        return evolveBestIndividualForBlock(block, evoSettings, cacheStatistics, recipeCache, warmStartBoard, surrogateModel, surrogateTrainer);
+    }
+
+    Recipe EvolutionaryFileCompressor::evolveBestIndividualForBlock(const Block & block, const Evolver::EvolutionSettings& evoSettings,
+                                                                    Evaluator::CacheStatistics& cacheStatistics, RecipeCache* recipeCache,
+                                                                    WarmStartBoard* warmStartBoard, const SurrogateModel* surrogateModel,
+                                                                    SurrogateModel::Trainer* surrogateTrainer) {
         //uses a sample of the actual block
         const Block blockSample = getBlockSample(block);
+        std::optional<RecipeCache::Key> recipeCacheKey;
+        if (recipeCache != nullptr) {
+            recipeCacheKey = RecipeCache::makeKey(blockSample, evoSettings, surrogateModel, warmStartBoard != nullptr);
+            if (std::optional<Recipe> cached = recipeCache->find(*recipeCacheKey)) {
+                if (warmStartBoard != nullptr) warmStartBoard->publish(blockSample, {*cached});
+                return *cached;
+            }
+        }
+
+        TransformPrefixCache prefixCache;
+        const SurrogateModel::Features features = SurrogateModel::getFeatures(blockSample);
         auto getFitnessOfIndividual = [&](const Recipe& recipe){
-            return getAdjustedFitnessOfIndividual(recipe, blockSample);
+            return getAdjustedFitnessOfIndividual(recipe, blockSample, prefixCache);
         };
-
-        Evolver evolver(evoSettings, getFitnessOfIndividual);
-        Recipe bestIndividual = evolver.evolveBest();
+        Evaluator::Surrogate surrogate;
+        if (surrogateModel != nullptr)
+            surrogate = [surrogateModel, &features](const Recipe& recipe){ return surrogateModel->predict(features, recipe); };
+        const std::vector<Recipe> hint = (warmStartBoard != nullptr) ? warmStartBoard->findHint(blockSample) : std::vector<Recipe>();
+
+        const bool usesLowFidelity = evoSettings.lowFidelitySampleSize > 0 && evoSettings.lowFidelitySampleSize < blockSample.size();
+        const Block lowFidelitySample = usesLowFidelity ? getBlockSample(block, evoSettings.lowFidelitySampleSize) : Block();
+        TransformPrefixCache lowFidelityPrefixCache;
+        Evaluator::FitnessFunction getLowFidelityFitnessOfIndividual;
+        if (usesLowFidelity)
+            getLowFidelityFitnessOfIndividual = [&](const Recipe& recipe){
+                return getAdjustedFitnessOfIndividual(recipe, lowFidelitySample, lowFidelityPrefixCache);
+            };
+
+        //the fitness function is called from the evaluation threads, so the samples for the surrogate come from the (ordered) evaluation log instead
+        Evolver::EvolutionSettings engineSettings = evoSettings;
+        engineSettings.keepsEvaluationLog = surrogateTrainer != nullptr;
+
+        Recipe bestIndividual;
+        std::vector<Recipe> elite;
+        std::vector<Evaluator::Evaluation> evaluationLog;
+        if (block.size() <= evoSettings.beamSearchMaxSegmentSize) {
+            BeamSearcher searcher(engineSettings, getFitnessOfIndividual);
+            bestIndividual = searcher.searchBest();
+            cacheStatistics = searcher.getFitnessCacheStatistics();
+            elite = searcher.getElite(evoSettings.eliteSize);
+            evaluationLog = searcher.getEvaluationLog();
+        }
+        else if (evoSettings.islandAmount > 1) {
+            IslandEvolver islands(engineSettings, getFitnessOfIndividual, hint);
+            if (surrogate) islands.setSurrogate(surrogate);
+            if (usesLowFidelity) islands.setLowFidelityFitnessFunction(getLowFidelityFitnessOfIndividual);
+            bestIndividual = islands.evolveBest();
+            cacheStatistics = islands.getFitnessCacheStatistics();
+            elite = islands.getElite(evoSettings.eliteSize);
+            evaluationLog = islands.getEvaluationLog();
+        }
+        else {
+            Evolver evolver(engineSettings, getFitnessOfIndividual, hint);
+            if (surrogate) evolver.setSurrogate(surrogate);
+            if (usesLowFidelity) evolver.setLowFidelityFitnessFunction(getLowFidelityFitnessOfIndividual);
+            bestIndividual = evolver.evolveBest();
+            cacheStatistics = evolver.getFitnessCacheStatistics();
+            elite = evolver.getElite(evoSettings.eliteSize);
+            evaluationLog = evolver.getEvaluationLog();
+        }
+        if (surrogateTrainer != nullptr)
+            for (const auto& [recipe, fitness]: evaluationLog) surrogateTrainer->addSample(features, recipe, fitness);
+        if (evoSettings.championSampleSize > blockSample.size() && block.size() > blockSample.size()) {
+            std::vector<Recipe> candidates{bestIndividual}; //first, so that it stays the pick unless another one is actually better
+            for (const Recipe& recipe: elite)
+                if (std::find(candidates.begin(), candidates.end(), recipe) == candidates.end()) candidates.push_back(recipe);
+            bestIndividual = pickChampion(candidates, block, evoSettings.championSampleSize);
+        }
+        if (recipeCache != nullptr) recipeCache->store(*recipeCacheKey, bestIndividual);
+        if (warmStartBoard != nullptr) {
+            elite.erase(std::remove(elite.begin(), elite.end(), bestIndividual), elite.end());
+            elite.insert(elite.begin(), bestIndividual); //the best goes first, it's what the next segment compares against
+            warmStartBoard->publish(blockSample, elite);
+        }
         return bestIndividual;
     }
 
+    Recipe EvolutionaryFileCompressor::pickChampion(const std::vector<Recipe>& candidates, const Block& block, const size_t sampleSize) {
+        ASSERT_NOT_EMPTY(candidates);
+        const Block championSample = getBlockSample(block, sampleSize);
+        TransformPrefixCache prefixCache;
+        const Recipe* champion = nullptr;
+        Fitness championFitness = std::numeric_limits<Fitness>::max();
+        for (const Recipe& candidate: candidates) {
+            const Fitness fitness = getAdjustedFitnessOfIndividual(candidate, championSample, prefixCache);
+            if (fitness < championFitness) {
+                championFitness = fitness;
+                champion = &candidate;
+            }
+        }
+        return *champion;
+    }
+
+    EffortScheduler EvolutionaryFileCompressor::makeEffortScheduler(const size_t fileSize, const EvoComSettings& settings) {
+        return EffortScheduler(fileSize, settings.fileEvaluationBudget, EffortScheduler::Milliseconds(settings.fileTimeBudgetInMilliseconds));
+    }
+
+    std::unique_ptr<WarmStartBoard> EvolutionaryFileCompressor::makeWarmStartBoard(const EvoComSettings& settings) {
+        if (!settings.warmStart) return nullptr;
+        return std::make_unique<WarmStartBoard>();
+    }
+
+    std::unique_ptr<SurrogateModel> EvolutionaryFileCompressor::loadSurrogateModel(const EvoComSettings& settings) {
+        if (settings.surrogateModelFile.empty()) return nullptr;
+        std::optional<SurrogateModel> model = SurrogateModel::load(settings.surrogateModelFile);
+        if (!model) {
+            LOG("ERROR: could not load the surrogate model from", settings.surrogateModelFile, ", every child will be evaluated");
+            return nullptr;
+        }
+        return std::make_unique<SurrogateModel>(*model);
+    }
+
+    std::unique_ptr<RecipeCache> EvolutionaryFileCompressor::openRecipeCache(const EvoComSettings& settings) {
+        if (settings.recipeCacheFile.empty()) return nullptr;
+        return std::make_unique<RecipeCache>(settings.recipeCacheFile, settings.recipeCacheCapacity);
+    }
+
     Recipe EvolutionaryFileCompressor::evolveIndividualForBlockAndLogProgress(const Block& block, const Evolver::EvolutionSettings& evoSettings, Logger& logger)  { //based on evolveBestIndividual
         const Block blockSample = getBlockSample(block);
+        TransformPrefixCache prefixCache;
         auto getFitnessOfIndividual = [&](const Recipe& recipe) -> Fitness {
-            return getAdjustedFitnessOfIndividual(recipe, blockSample);
+            return getAdjustedFitnessOfIndividual(recipe, blockSample, prefixCache);
         };
 
         Evolver evolver(evoSettings, getFitnessOfIndividual);
@@ -469,6 +835,7 @@ namespace GC {
 
         auto compressBlock = [&](const Block& block) {
             LOG("Compressing a block that's of size", block.size());
+            evoSettings.seed = RandomGenerator::deriveSeed(settings.seed, segmentCounter);
             segmentCounter++;
             evolveIndividualForBlockAndLogProgress(block, evoSettings, logger);  //doesn't use the return value
         };
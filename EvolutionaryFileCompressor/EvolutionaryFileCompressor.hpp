@@ -16,8 +16,17 @@
 #include "../AbstractBit/AbstractBitReader/AbstractBitReader.hpp"
 #include "EvoCompressorSettings/EvoComSettings.hpp"
 #include "../Evolver/Evolver.hpp"
+#include "../Evolver/IslandEvolver/IslandEvolver.hpp"
+#include "../Evolver/BeamSearcher/BeamSearcher.hpp"
 #include "../Evolver/Evaluator/BitCounter/BitCounter.hpp"
 #include "../AbstractBit/FileBitReader/FileBitReader.hpp"
+#include "TransformPrefixCache.hpp"
+#include "RecipeCache.hpp"
+#include "EffortScheduler.hpp"
+#include "WarmStartBoard.hpp"
+#include "SurrogateModel.hpp"
+#include <unordered_map>
+#include <optional>
 
 namespace GC {
 
@@ -30,13 +39,36 @@ namespace GC {
         using CompressionCode = CCode;
         using Fitness = Recipe::FitnessScore;
 
+        /**
+         * The two buffers that a recipe's transforms ping-pong between.
+         * When the same buffers are reused for many recipes (eg during evolution), they stop allocating once they're large enough.
+         */
+        struct TransformBuffers {
+            Block front;
+            Block back;
+        };
+
+        /**
+         * The distinct recipes used so far in a file (from format version 2).
+         * A segment's recipe is written as a bit which is set when it's the same as the one of the previous segment,
+         * otherwise as a bit which tells if the recipe is new (written in full and added to the table) or an index in the table.
+         * That bit is left out while the table has at most one recipe, since a recipe which isn't the previous one must then be new.
+         * The compressor and the decompressor both build the table as they go, so it's never stored on its own.
+         */
+        struct RecipeTable {
+            std::vector<Recipe> recipes;
+            std::unordered_map<Recipe, size_t> indexes;
+            size_t previousIndex = 0;
+        };
+
 
         EvolutionaryFileCompressor() {};
         static void compress(const EvoComSettings &settings);
         static void decompress(const FileName& fileToDecompress, const FileName& outputFile);
 
 
-        static void processSingleFileForCompressionDataCollection(const FileName& file, const EvoComSettings& settings, Logger& logger);
+        static void processSingleFileForCompressionDataCollection(const FileName& file, const EvoComSettings& settings, Logger& logger,
+                                                                  SurrogateModel::Trainer* surrogateTrainer = nullptr);
         static void generateCompressionData(const EvoComSettings &settings, Logger& logger);
 
 
@@ -51,24 +83,91 @@ namespace GC {
 
 
     public: //for the purposes of testing
+        /**
+         * Files from format version 1 onwards start with versionedFileMarker followed by the version.
+         * A legacy file (version 0) can't start with the marker, because its first nibble is the amount of transforms of the first recipe.
+         * In version 0 every code takes 4 bits; from version 1 a code is written in 4 bits if it's below escapeCode,
+         * otherwise as escapeCode followed by (code - escapeCode) as a small amount. Parameterised transforms also write their parameter.
+         * From version 2 the recipes are referenced through a RecipeTable.
+         */
+        static constexpr size_t versionedFileMarker = 0xF;
+        static constexpr size_t bitsForFormatVersion = 4;
+        static constexpr size_t legacyFormatVersion = 0;
+        static constexpr size_t firstVersionWithEscapedCodes = 1;
+        static constexpr size_t currentFormatVersion = 2;
+        static constexpr size_t firstVersionWithRecipeTable = 2;
+        static constexpr size_t escapeCode = 0xF;
+
         static void applyTransformCode(const TransformCode &tc, Block &block);
 
+        static void applyTransformCode(const TransformCode &tc, const Block &input, Block &output);
+
+        static const Block& applyRecipeTransforms(const Recipe &recipe, const Block &block, TransformBuffers& buffers);
+
+        static const Block& applyRecipeTransforms(const Recipe &recipe, const Block &block, TransformBuffers& buffers, TransformPrefixCache& prefixCache);
+
         static void applyCompressionCode(const CompressionCode &cc, const Block &block, AbstractBitWriter& writer);
 
         static void compressBlockUsingRecipe_DataCollection(const Recipe &individual, const Block &block, GC::BitCounter &writer, Logger& logger);
         static void compressBlockUsingRecipe(const Recipe &individual, const Block &block, AbstractBitWriter& writer);
+        static void compressBlockUsingRecipe(const Recipe &individual, const Block &block, AbstractBitWriter& writer, TransformBuffers& buffers);
+
+        static void writeFileHeader(AbstractBitWriter& writer);
 
         static void encodeIndividual(const Recipe &individual, AbstractBitWriter& writer);
 
+        /**
+         * @return nothing when the file holds a recipe which can't be decoded, after logging why
+         */
+        static std::optional<Recipe> decodeIndividual(AbstractBitReader &reader, const size_t formatVersion);
+
+        static void encodeRecipeReference(const Recipe &recipe, RecipeTable &table, AbstractBitWriter &writer);
+
+        static std::optional<Recipe> decodeRecipeReference(RecipeTable &table, AbstractBitReader &reader, const size_t formatVersion);
+
+        static void decompressFromStreams(AbstractBitReader &reader, AbstractBitWriter &writer);
+
         static void undoTransformCode(const TransformCode &tc, Block &block);
 
         static Block undoCompressionCode(const CompressionCode &cc, AbstractBitReader &reader);
 
+        /**
+         * When a recipe cache is given, it's consulted before evolving (on a hit there's no evolution at all) and it's updated afterwards.
+         * When a warm start board is given, the population starts from the elite of the most similar segment on it, and the elite of this one is added to it.
+         * When a surrogate model is given, the children it estimates to be clearly bad aren't evaluated.
+         * The segments of at most evoSettings.beamSearchMaxSegmentSize bytes use a BeamSearcher instead (which ignores the hint and the surrogate).
+         * When a surrogate trainer is given, every actual evaluation is added to it.
+         * With multi fidelity evaluation, the children are first scored on a smaller sample, and the elite is compared again on a larger one.
+         */
+        static Recipe evolveBestIndividualForBlock(const Block &block, const Evolver::EvolutionSettings& evoSettings,
+                                                   RecipeCache* recipeCache = nullptr, WarmStartBoard* warmStartBoard = nullptr,
+                                                   const SurrogateModel* surrogateModel = nullptr, SurrogateModel::Trainer* surrogateTrainer = nullptr);
+
+        static Recipe evolveBestIndividualForBlock(const Block &block, const Evolver::EvolutionSettings& evoSettings,
+                                                   Evaluator::CacheStatistics& cacheStatistics, RecipeCache* recipeCache = nullptr,
+                                                   WarmStartBoard* warmStartBoard = nullptr, const SurrogateModel* surrogateModel = nullptr,
+                                                   SurrogateModel::Trainer* surrogateTrainer = nullptr);
+
+        /**
+         * Compares the candidates again on the first sampleSize bytes of the block
+         * @return the best of them, the earliest among equally good ones
+         */
+        static Recipe pickChampion(const std::vector<Recipe>& candidates, const Block& block, const size_t sampleSize);
+
     private:
 
-        static TransformCode decodeTransformCode(AbstractBitReader &reader);
+        static void writeEscapedCode(const size_t code, AbstractBitWriter &writer);
+
+        static size_t readEscapedCode(AbstractBitReader &reader);
+
+        static void encodeTransformCode(const TransformCode tc, AbstractBitWriter &writer);
 
-        static CompressionCode decodeCompressionCode(AbstractBitReader &reader);
+        /**
+         * @return nothing when a parameterised transform has an unknown parameter, after logging it
+         */
+        static std::optional<TransformCode> decodeTransformCode(AbstractBitReader &reader, const size_t formatVersion);
+
+        static CompressionCode decodeCompressionCode(AbstractBitReader &reader, const size_t formatVersion);
 
         static void readBlockAndEncode(size_t size, AbstractBitReader &reader, AbstractBitWriter &writer);
 
@@ -76,9 +175,9 @@ namespace GC {
 
         static void writeBlock(const Block &block, AbstractBitWriter &writer);
 
-        static Fitness compressionRatioForIndividualOnBlock(const Recipe &individual, const Block &block);
+        static Fitness compressionRatioForIndividualOnBlock(const Recipe &individual, const Block &block, TransformPrefixCache& prefixCache);
 
-        static Recipe decodeIndividual(AbstractBitReader &reader);
+        static std::optional<Recipe> decodeIndividual(const size_t amountOfTransforms, AbstractBitReader &reader, const size_t formatVersion);
 
         static Block decodeUsingIndividual(const Recipe &individual, AbstractBitReader &reader);
 
@@ -87,7 +186,13 @@ namespace GC {
                               const size_t fileSize, const EvoComSettings& settings);
 
 
-        static Recipe evolveBestIndividualForBlock(const Block &block, const Evolver::EvolutionSettings& evoSettings);
+        static std::unique_ptr<RecipeCache> openRecipeCache(const EvoComSettings& settings);
+
+        static EffortScheduler makeEffortScheduler(const size_t fileSize, const EvoComSettings& settings);
+
+        static std::unique_ptr<WarmStartBoard> makeWarmStartBoard(const EvoComSettings& settings);
+
+        static std::unique_ptr<SurrogateModel> loadSurrogateModel(const EvoComSettings& settings);
 
         static void processFileAsFixedSegments(AbstractBitReader &reader, const std::function<void(
                 const Block &)> &blockHandler,
@@ -102,7 +207,7 @@ namespace GC {
 
         static void compressToStreamsSequentially_DataCollection(AbstractBitReader &reader, BitCounter &writer,
                                                                  const size_t originalFileSize, const EvoComSettings &settings,
-                                                                 Logger &logger);
+                                                                 Logger &logger, SurrogateModel::Trainer* surrogateTrainer = nullptr);
 
         static void getEvolverConvergenceData(GC::FileBitReader &reader, const size_t size,
                                               const EvoComSettings &settings, Logger& logger);
@@ -112,9 +217,9 @@ namespace GC {
 
         static double adjustFitness(const double oldFitness, const Recipe& recipe);
 
-        static double getAdjustedFitnessOfIndividual(const Recipe &recipe, const Block &block);
+        static double getAdjustedFitnessOfIndividual(const Recipe &recipe, const Block &block, TransformPrefixCache& prefixCache);
 
-        static Block getBlockSample(const Block &block);
+        static Block getBlockSample(const Block &block, const size_t sampleSize = 1024); //1 KB
     };
 
 } // GC
@@ -0,0 +1,213 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "RecipeCache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace GC {
+
+    namespace {
+        uint64_t mix(uint64_t x) {
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+            return x ^ (x >> 31);
+        }
+
+        uint64_t rotateLeft(const uint64_t x, const int k) {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        //two 64 bit lanes which absorb different functions of each word, so that they don't collide together
+        class Fingerprint {
+            uint64_t low = 0x243F6A8885A308D3ULL;
+            uint64_t high = 0x13198A2E03707344ULL;
+
+        public:
+            void addWord(const uint64_t word) {
+                low = mix(low ^ word) + 0x9E3779B97F4A7C15ULL;
+                high = rotateLeft(high ^ (word * 0xC2B2AE3D27D4EB4FULL), 29) * 0x165667B19E3779F9ULL + low;
+            }
+
+            void addDouble(const double value) {
+                uint64_t word;
+                std::memcpy(&word, &value, sizeof(word));
+                addWord(word);
+            }
+
+            void addBytes(const Unit* data, const size_t size) {
+                size_t i = 0;
+                for (;i+8<=size;i+=8) {
+                    uint64_t word;
+                    std::memcpy(&word, data+i, 8);
+                    addWord(word);
+                }
+                uint64_t tail = 0;
+                std::memcpy(&tail, data+i, size-i);
+                addWord(tail);
+                addWord(size);
+            }
+
+            RecipeCache::Key getKey() const {
+                RecipeCache::Key key{mix(low ^ rotateLeft(high, 32)), mix(high + low)};
+                if (key.isEmpty()) key.low = 1; //the empty key marks the unused records
+                return key;
+            }
+        };
+    }
+
+    RecipeCache::RecipeCache(const std::string& fileName, const size_t capacity) :
+        fileName(fileName),
+        records(std::max<size_t>(capacity, probeWindow)) {
+        load();
+    }
+
+    void RecipeCache::load() {
+        std::ifstream inStream(fileName, std::ios::binary);
+        if (!inStream) return; //there's no cache yet
+
+        Header header;
+        inStream.read(reinterpret_cast<char*>(&header), sizeof(header));
+        const bool isCompatible = inStream && header.magic == magic && header.version == formatVersion
+                                  && header.recordSize == sizeof(Record) && header.capacity == records.size();
+        if (!isCompatible) {
+            LOG("The recipe cache", fileName, "has a different format or capacity, it will be replaced");
+            return;
+        }
+
+        inStream.read(reinterpret_cast<char*>(records.data()), records.size()*sizeof(Record));
+        if (!inStream) {
+            LOG("The recipe cache", fileName, "is truncated, it will be replaced");
+            std::fill(records.begin(), records.end(), Record{});
+            return;
+        }
+        clock = header.clock;
+    }
+
+    void RecipeCache::save() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!isDirty || fileName.empty()) return;
+
+        const std::string temporaryFileName = fileName+".tmp";
+        {
+            std::ofstream outStream(temporaryFileName, std::ios::binary | std::ios::trunc);
+            const Header header{magic, formatVersion, sizeof(Record), records.size(), clock};
+            outStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            outStream.write(reinterpret_cast<const char*>(records.data()), records.size()*sizeof(Record));
+            if (!outStream) {
+                LOG("The recipe cache could not be written to", temporaryFileName);
+                return;
+            }
+        }
+        if (std::rename(temporaryFileName.c_str(), fileName.c_str()) != 0) {
+            LOG("The recipe cache could not be moved to", fileName);
+            return;
+        }
+        isDirty = false;
+    }
+
+    RecipeCache::Key RecipeCache::makeKey(const Block& sample, const Evolver::EvolutionSettings& evoSettings,
+                                          const SurrogateModel* surrogateModel, const bool usesWarmStart) {
+        //every setting which affects the chosen recipe, in a fixed order
+        const std::vector<double> resultAffectingSettings = {
+                (double)evoSettings.populationSize,
+                (double)evoSettings.generationCount,
+                evoSettings.chanceOfMutation,
+                evoSettings.chanceOfCompressionCrossover,
+                evoSettings.tournamentSelectionProportion,
+                (double)evoSettings.usesSimulatedAnnealing,
+                (double)evoSettings.eliteSize,
+                evoSettings.mutationThreshold,
+                (double)evoSettings.minTransformAmount,
+                (double)evoSettings.maxTransformAmount,
+                (double)evoSettings.stagnationLimit,
+                evoSettings.targetFitness,
+                (double)evoSettings.islandAmount,
+                (double)evoSettings.migrationInterval,
+                (double)evoSettings.migrantAmount,
+                (double)usesWarmStart,
+                (double)evoSettings.warmStartCheckGeneration,
+                evoSettings.warmStartTolerance,
+                (double)(surrogateModel != nullptr),
+                evoSettings.surrogateMargin,
+                (double)evoSettings.beamSearchMaxSegmentSize,
+                (double)evoSettings.beamWidth,
+                (double)evoSettings.beamDepth,
+                (double)evoSettings.lowFidelitySampleSize,
+                evoSettings.promotedProportion,
+                (double)evoSettings.championSampleSize};
+
+        Fingerprint fingerprint;
+        fingerprint.addWord(formatVersion);
+        for (const double setting: resultAffectingSettings) fingerprint.addDouble(setting);
+        if (surrogateModel != nullptr) //a retrained model screens different children
+            for (const double weight: surrogateModel->getWeights()) fingerprint.addDouble(weight);
+        fingerprint.addBytes(sample.data(), sample.size());
+        return fingerprint.getKey();
+    }
+
+    bool RecipeCache::isValid(const Record& record) {
+        if (record.tListLength > maxStoredTransforms || record.cCode >= C_AmountOfCCodes) return false;
+        return std::all_of(record.tCodes.begin(), record.tCodes.begin()+record.tListLength,
+                           [](const uint8_t tCode){return tCode < T_AmountOfTCodes;});
+    }
+
+    std::optional<Recipe> RecipeCache::find(const Key& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const size_t start = windowStart(key);
+        for (size_t i=0;i<probeWindow;i++) {
+            Record& record = records[(start+i) % records.size()];
+            if (!(record.key == key)) continue;
+
+            if (!isValid(record)) { //a damaged file, or one written by a build with other codes
+                LOG("The recipe cache", fileName, "has a record with unknown codes, it's dropped");
+                record = Record{};
+                isDirty = true;
+                break;
+            }
+
+            statistics.hits++;
+            record.lastUsed = ++clock; //only written with the next change, a hit alone doesn't rewrite the file
+
+            Recipe recipe;
+            recipe.cCode = static_cast<CCode>(record.cCode);
+            for (size_t t=0;t<record.tListLength;t++)
+                recipe.tList.push_back(static_cast<TCode>(record.tCodes[t]));
+            recipe.getPseudoFitness().setFitnessScore(record.fitness);
+            recipe.getPseudoFitness().setReliability(1.0);
+            return recipe;
+        }
+        statistics.misses++;
+        return {};
+    }
+
+    void RecipeCache::store(const Key& key, const Recipe& recipe) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const size_t start = windowStart(key);
+        Record* target = nullptr;
+        for (size_t i=0;i<probeWindow;i++) {
+            Record& record = records[(start+i) % records.size()];
+            if (record.key == key || record.key.isEmpty()) {
+                target = &record;
+                break;
+            }
+            if (target == nullptr || record.lastUsed < target->lastUsed)
+                target = &record;
+        }
+        if (!target->key.isEmpty() && !(target->key == key)) statistics.evictions++;
+
+        Record record{};
+        record.key = key;
+        record.fitness = recipe.getFitness();
+        record.lastUsed = ++clock;
+        record.cCode = static_cast<uint8_t>(recipe.cCode);
+        record.tListLength = recipe.tList.size();
+        for (size_t t=0;t<recipe.tList.size();t++)
+            record.tCodes[t] = static_cast<uint8_t>(recipe.tList[t]);
+        *target = record;
+        isDirty = true;
+    }
+
+} // GC
@@ -0,0 +1,130 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_RECIPECACHE_HPP
+#define EVOCOM_RECIPECACHE_HPP
+
+#include "../names.hpp"
+#include "../Evolver/Recipe/Recipe.hpp"
+#include "../Evolver/Evolver.hpp"
+#include "SurrogateModel.hpp"
+#include <array>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace GC {
+
+    /**
+     * Remembers, across runs, the recipe that evolution chose for a segment.
+     * The key is a 128 bit fingerprint of the sample that the evolution sees together with the settings which affect it
+     * (population, generations, rates, the engine, the surrogate and warm start.. but not the seed, otherwise every run would have a different key,
+     * nor the time and evaluation budgets, which depend on the rest of the file),
+     * so a segment that hasn't changed since the last run can skip the evolution entirely.
+     *
+     * The file is a small header followed by a fixed amount of fixed size records (an open addressing table, probed linearly within a window),
+     * so it's bounded. It's read whole when the cache is opened and rewritten by save (through a temporary file), when something was stored.
+     * A record with codes this build doesn't know is treated as a miss and dropped.
+     * When a window is full, the least recently used record in it is replaced.
+     *
+     * All the methods take a lock, since in the asynchronous mode each segment evolves on its own thread.
+     */
+    class RecipeCache {
+    public:
+        struct Key {
+            uint64_t low = 0, high = 0;
+            bool operator==(const Key& other) const { return low == other.low && high == other.high; }
+            bool isEmpty() const { return low == 0 && high == 0; }
+        };
+
+        struct Statistics {
+            size_t hits = 0;
+            size_t misses = 0;
+            size_t evictions = 0;
+
+            std::string to_string() const {
+                std::stringstream ss;
+                ss<<"{RecipeCache: hits="<<hits<<", misses="<<misses<<", evictions="<<evictions<<"}";
+                return ss.str();
+            }
+        };
+
+        static constexpr size_t defaultCapacity = 64*1024; //3 MB on disk
+        static constexpr size_t maxStoredTransforms = Recipe::TList::capacity;
+        static constexpr size_t probeWindow = 8;
+        static constexpr uint32_t formatVersion = 2; //increase when the records, the transforms or the fitness function change
+
+    private:
+        struct Record {
+            Key key;
+            double fitness;
+            uint64_t lastUsed;
+            uint8_t cCode;
+            uint8_t tListLength;
+            std::array<uint8_t, maxStoredTransforms> tCodes;
+        };
+        static_assert(sizeof(Record) == 48); //no padding
+
+        struct Header {
+            std::array<char, 8> magic;
+            uint32_t version;
+            uint32_t recordSize;
+            uint64_t capacity;
+            uint64_t clock;
+        };
+        static constexpr std::array<char, 8> magic{'E', 'V', 'O', 'R', 'C', 'P', 'E', 'S'};
+
+        std::string fileName;
+        std::vector<Record> records;
+        uint64_t clock = 0; //increased on every access, it's what lastUsed refers to
+        bool isDirty = false;
+        Statistics statistics;
+        mutable std::mutex mutex;
+
+        size_t windowStart(const Key& key) const { return key.low % records.size(); }
+        static bool isValid(const Record& record);
+        void load();
+
+    public:
+        RecipeCache(const std::string& fileName, const size_t capacity = defaultCapacity);
+
+        RecipeCache(const RecipeCache&) = delete;
+        RecipeCache& operator=(const RecipeCache&) = delete;
+
+        ~RecipeCache() { save(); }
+
+        /**
+         * @param surrogateModel the model which screens the children, if any
+         * @param usesWarmStart whether the population starts from the elite of a similar segment
+         */
+        static Key makeKey(const Block& sample, const Evolver::EvolutionSettings& evoSettings,
+                           const SurrogateModel* surrogateModel = nullptr, const bool usesWarmStart = false);
+
+        /**
+         * @return the stored recipe for the key, with its fitness as an actual fitness.
+         * A hit updates the recency of the record in memory, it's saved along with the next change
+         */
+        std::optional<Recipe> find(const Key& key);
+
+        /**
+         * Stores the recipe (and its fitness), replacing the least recently used record of the window when it's full
+         */
+        void store(const Key& key, const Recipe& recipe);
+
+        /**
+         * Writes the records to the file, if anything changed since it was read
+         */
+        void save();
+
+        Statistics getStatistics() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return statistics;
+        }
+
+        size_t getCapacity() const { return records.size(); }
+    };
+
+} // GC
+
+#endif //EVOCOM_RECIPECACHE_HPP
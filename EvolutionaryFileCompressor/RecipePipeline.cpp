@@ -0,0 +1,32 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "RecipePipeline.hpp"
+#include <unordered_map>
+
+namespace GC {
+
+    namespace {
+        template <CCode cCode, TCode... tCodes>
+        std::pair<Recipe, SpecialisedPipeline> registryEntry() {
+            return {RecipePipeline<cCode, tCodes...>::getRecipe(), SpecialisedPipeline::of<cCode, tCodes...>()};
+        }
+
+        //the recipes that the evolver ends up choosing most often
+        std::unordered_map<Recipe, SpecialisedPipeline> makeRegistry() {
+            return {registryEntry<C_HuffmanCompression, T_DeltaTransform>(),
+                    registryEntry<C_HuffmanCompression, T_StrideTransform_4, T_DeltaTransform>(),
+                    registryEntry<C_HuffmanCompression, T_BurrowsWheelerTransform, T_StackTransform>(),
+                    registryEntry<C_HuffmanCompression, T_DeltaTransform, T_StackTransform>(),
+                    registryEntry<C_HuffmanCompression, T_StrideTransform_4, T_DeltaTransform, T_StackTransform>()};
+        }
+    }
+
+    const SpecialisedPipeline* findSpecialisedPipeline(const Recipe& recipe) {
+        static const std::unordered_map<Recipe, SpecialisedPipeline> registry = makeRegistry();
+        const auto found = registry.find(recipe);
+        return (found == registry.end()) ? nullptr : &found->second;
+    }
+
+} // GC
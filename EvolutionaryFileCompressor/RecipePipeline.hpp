@@ -0,0 +1,249 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_RECIPEPIPELINE_HPP
+#define EVOCOM_RECIPEPIPELINE_HPP
+
+#include "EvolutionaryFileCompressor.hpp"
+
+#include "../Transformation/Transformations/DeltaTransform.hpp"
+#include "../Transformation/Transformations/DeltaXORTransform.hpp"
+#include "../Transformation/Transformations/RunLengthTransform.hpp"
+#include "../Transformation/Transformations/SplitTransform.hpp"
+#include "../Transformation/Transformations/SubtractAverageTransform.hpp"
+#include "../Transformation/Transformations/SubtractXORAverageTransform.hpp"
+#include "../Transformation/Transformations/StrideTransform.hpp"
+#include "../Transformation/Transformations/StackTransform.hpp"
+#include "../Transformation/Transformations/IdentityTransform.hpp"
+#include "../Transformation/Transformations/LempelZivWelchTransform.hpp"
+#include "../Transformation/Transformations/BurrowsWheelerTransform.hpp"
+#include "../Transformation/Transformations/SubMinAdaptiveTransform.hpp"
+#include "../Transformation/Transformations/BlockSortingTransform.hpp"
+#include "../Transformation/Transformations/LaneDeltaTransform.hpp"
+
+#include "../Compression/HuffmanCompression/HuffmanCompression.hpp"
+#include "../Compression/IdentityCompression/IdentityCompression.hpp"
+#include "../Compression/NRLCompression/NRLCompression.hpp"
+#include "../Compression/SmallValueCompression/SmallValueCompression.hpp"
+#include "../Compression/LZWCompression/LZWCompression.hpp"
+
+#include <array>
+#include <tuple>
+#include <utility>
+
+namespace GC {
+
+    namespace PipelineStages {
+
+        //the concrete transform for each code, so that the pipeline calls it directly instead of going through the dispatch switch
+        template <TCode tCode> struct Transform;
+#define GC_PIPELINE_TRANSFORM(CODE, ...) template <> struct Transform<CODE> { static auto make() { return __VA_ARGS__; } };
+        GC_PIPELINE_TRANSFORM(T_DeltaTransform, DeltaTransform())
+        GC_PIPELINE_TRANSFORM(T_DeltaXORTransform, DeltaXORTransform())
+        GC_PIPELINE_TRANSFORM(T_RunLengthTransform, RunLengthTransform())
+        GC_PIPELINE_TRANSFORM(T_StackTransform, StackTransform())
+        GC_PIPELINE_TRANSFORM(T_SplitTransform, SplitTransform())
+        GC_PIPELINE_TRANSFORM(T_StrideTransform_2, StrideTransform(2))
+        GC_PIPELINE_TRANSFORM(T_StrideTransform_3, StrideTransform(3))
+        GC_PIPELINE_TRANSFORM(T_StrideTransform_4, StrideTransform(4))
+        GC_PIPELINE_TRANSFORM(T_StrideTransform_8, StrideTransform(8))
+        GC_PIPELINE_TRANSFORM(T_StrideTransform_12, StrideTransform(12))
+        GC_PIPELINE_TRANSFORM(T_StrideTransform_16, StrideTransform(16))
+        GC_PIPELINE_TRANSFORM(T_SubtractAverageTransform, SubtractAverageTransform())
+        GC_PIPELINE_TRANSFORM(T_SubtractXORAverageTransform, SubtractXORAverageTransform())
+        GC_PIPELINE_TRANSFORM(T_IdentityTransform, IdentityTransform())
+        GC_PIPELINE_TRANSFORM(T_LempelZivWelchTransform, LempelZivWelchTransform())
+        GC_PIPELINE_TRANSFORM(T_BurrowsWheelerTransform, BurrowsWheelerTransform())
+        GC_PIPELINE_TRANSFORM(T_SubMinAdaptiveTransform, SubMinAdaptiveTransform())
+        GC_PIPELINE_TRANSFORM(T_BlockSortingTransform, BlockSortingTransform())
+        GC_PIPELINE_TRANSFORM(T_DeltaTransform_16, LaneDeltaTransform(2, false))
+        GC_PIPELINE_TRANSFORM(T_DeltaTransform_32, LaneDeltaTransform(4, false))
+        GC_PIPELINE_TRANSFORM(T_DeltaTransform_64, LaneDeltaTransform(8, false))
+        GC_PIPELINE_TRANSFORM(T_DeltaXORTransform_16, LaneDeltaTransform(2, true))
+        GC_PIPELINE_TRANSFORM(T_DeltaXORTransform_32, LaneDeltaTransform(4, true))
+        GC_PIPELINE_TRANSFORM(T_DeltaXORTransform_64, LaneDeltaTransform(8, true))
+#undef GC_PIPELINE_TRANSFORM
+
+        template <CCode cCode> struct Compression;
+#define GC_PIPELINE_COMPRESSION(CODE, ...) template <> struct Compression<CODE> { static auto make() { return __VA_ARGS__; } };
+        GC_PIPELINE_COMPRESSION(C_IdentityCompression, IdentityCompression())
+        GC_PIPELINE_COMPRESSION(C_HuffmanCompression, HuffmanCompression())
+        GC_PIPELINE_COMPRESSION(C_RunLengthCompression, NRLCompression())
+        GC_PIPELINE_COMPRESSION(C_SmallValueCompression, SmallValueCompression())
+        GC_PIPELINE_COMPRESSION(C_LZWCompression, LZWCompression())
+#undef GC_PIPELINE_COMPRESSION
+
+        /**
+         * Byte-local transforms: each output unit only depends on the input unit and on a small state carried from the previous units,
+         * and the output has the same size as the input. A run of these can be done in a single loop, one unit at a time.
+         */
+        template <TCode tCode> struct Local;
+
+        template <> struct Local<T_DeltaTransform> {
+            Unit previous = 0;
+            Unit encode(const Unit unit) { const Unit result = unit - previous; previous = unit; return result; }
+            Unit decode(const Unit unit) { previous += unit; return previous; }
+        };
+
+        template <> struct Local<T_DeltaXORTransform> {
+            Unit previous = 0;
+            Unit encode(const Unit unit) { const Unit result = unit ^ previous; previous = unit; return result; }
+            Unit decode(const Unit unit) { previous ^= unit; return previous; }
+        };
+
+        template <> struct Local<T_StackTransform> {
+            StackTransform::UnitTable table = StackTransform::getInitialTable();
+            Unit encode(const Unit unit) { return StackTransform::findInTableAndUpdate(unit, table); }
+            Unit decode(const Unit unit) { return StackTransform::getNthFromTableAndUpdate(unit, table); }
+        };
+
+        template <> struct Local<T_IdentityTransform> {
+            Unit encode(const Unit unit) { return unit; }
+            Unit decode(const Unit unit) { return unit; }
+        };
+
+        constexpr bool isLocal(const TCode tCode) {
+            return tCode == T_DeltaTransform || tCode == T_DeltaXORTransform || tCode == T_StackTransform || tCode == T_IdentityTransform;
+        }
+
+        //these already have vector kernels, which are faster on their own than a fused scalar loop
+        constexpr bool isVectorised(const TCode tCode) {
+            return tCode == T_DeltaTransform || tCode == T_DeltaXORTransform || tCode == T_IdentityTransform;
+        }
+    }
+
+    /**
+     * A recipe whose stages are known at compile time, eg RecipePipeline<C_HuffmanCompression, T_StrideTransform_4, T_DeltaTransform>.
+     * (the compression comes first because a parameter pack has to be last)
+     *
+     * The transforms are called on their concrete types, and consecutive byte-local transforms are fused into a single loop
+     * when that loop wouldn't replace their vector kernels (ie at least one of them is scalar anyway, such as the stack transform).
+     * The other transforms ping-pong between the TransformBuffers exactly like EvolutionaryFileCompressor::applyRecipeTransforms,
+     * so the output is bit for bit the same as the generic path.
+     */
+    template <CCode cCode, TCode... tCodes>
+    class RecipePipeline {
+    private:
+        using TransformBuffers = EvolutionaryFileCompressor::TransformBuffers;
+        static constexpr size_t amountOfStages = sizeof...(tCodes);
+        static constexpr std::array<TCode, amountOfStages> stages = {tCodes...};
+
+        //where the fused run starting at start ends, or start itself when the stage is done on its own
+        static constexpr size_t fusedRunEnd(const size_t start) {
+            size_t end = start;
+            bool hasScalarStage = false;
+            while (end < amountOfStages && PipelineStages::isLocal(stages[end])) {
+                hasScalarStage = hasScalarStage || !PipelineStages::isVectorised(stages[end]);
+                end++;
+            }
+            return (end-start >= 2 && hasScalarStage) ? end : start;
+        }
+
+        static constexpr size_t nextGroup(const size_t start) {
+            const size_t end = fusedRunEnd(start);
+            return (end > start) ? end : start+1;
+        }
+
+        //the start of the group (fused run or single stage) which contains the stage at index
+        static constexpr size_t groupContaining(const size_t index) {
+            size_t start = 0;
+            while (nextGroup(start) <= index)
+                start = nextGroup(start);
+            return start;
+        }
+
+        template <size_t start, size_t... offsets>
+        static void applyFused(const Block& input, Block& output, std::index_sequence<offsets...>) {
+            std::tuple<PipelineStages::Local<stages[start+offsets]>...> states;
+            output.resize(input.size());
+            for (size_t i=0;i<input.size();i++) {
+                Unit unit = input[i];
+                ((unit = std::get<offsets>(states).encode(unit)), ...);
+                output[i] = unit;
+            }
+        }
+
+        template <size_t start, size_t... offsets>
+        static void undoFused(Block& block, std::index_sequence<offsets...>) {
+            std::tuple<PipelineStages::Local<stages[start+offsets]>...> states;
+            constexpr size_t last = sizeof...(offsets)-1;
+            for (Unit& unit : block)
+                ((unit = std::get<last-offsets>(states).decode(unit)), ...);
+        }
+
+        template <size_t start>
+        static const Block& applyFrom(const Block& current, TransformBuffers& buffers) {
+            if constexpr (start == amountOfStages)
+                return current;
+            else {
+                Block& target = (&current == &buffers.front) ? buffers.back : buffers.front;
+                constexpr size_t end = fusedRunEnd(start);
+                if constexpr (end > start) {
+                    applyFused<start>(current, target, std::make_index_sequence<end-start>());
+                    return applyFrom<end>(target, buffers);
+                }
+                else {
+                    PipelineStages::Transform<stages[start]>::make().apply_into(current, target);
+                    return applyFrom<start+1>(target, buffers);
+                }
+            }
+        }
+
+        //undoes the stages in [0, end), last to first
+        template <size_t end>
+        static void undoUntil(Block& block) {
+            if constexpr (end > 0) {
+                constexpr size_t start = groupContaining(end-1);
+                if constexpr (fusedRunEnd(start) > start)
+                    undoFused<start>(block, std::make_index_sequence<end-start>());
+                else
+                    PipelineStages::Transform<stages[start]>::make().undo(block);
+                undoUntil<start>(block);
+            }
+        }
+
+    public:
+        static Recipe getRecipe() {
+            return Recipe({tCodes...}, cCode);
+        }
+
+        static const Block& applyTransforms(const Block& block, TransformBuffers& buffers) {
+            return applyFrom<0>(block, buffers);
+        }
+
+        static void compress(const Block& block, AbstractBitWriter& writer, TransformBuffers& buffers) {
+            auto compression = PipelineStages::Compression<cCode>::make();
+            compression.compress(applyTransforms(block, buffers), writer);
+        }
+
+        static Block decompress(AbstractBitReader& reader) {
+            auto compression = PipelineStages::Compression<cCode>::make();
+            Block block = compression.decompress(reader);
+            undoUntil<amountOfStages>(block);
+            return block;
+        }
+    };
+
+    /**
+     * The entry points of a RecipePipeline, so that recipes which are chosen very often can be routed to them at runtime.
+     */
+    struct SpecialisedPipeline {
+        using TransformBuffers = EvolutionaryFileCompressor::TransformBuffers;
+        void (*compress)(const Block& block, AbstractBitWriter& writer, TransformBuffers& buffers);
+        Block (*decompress)(AbstractBitReader& reader);
+
+        template <CCode cCode, TCode... tCodes>
+        static SpecialisedPipeline of() {
+            return {RecipePipeline<cCode, tCodes...>::compress, RecipePipeline<cCode, tCodes...>::decompress};
+        }
+    };
+
+    /**
+     * @return the specialised pipeline registered for this recipe, or nullptr if it has to go through the generic dispatch
+     */
+    const SpecialisedPipeline* findSpecialisedPipeline(const Recipe& recipe);
+
+} // GC
+
+#endif //EVOCOM_RECIPEPIPELINE_HPP
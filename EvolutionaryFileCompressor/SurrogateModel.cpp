@@ -0,0 +1,148 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "SurrogateModel.hpp"
+#include "../BlockReport/BlockReport.hpp"
+#include <cmath>
+#include <fstream>
+
+namespace GC {
+
+    namespace {
+        //the entropy (in bytes, so from 0 to 1) of the differences between the units at the given distance
+        double getEntropyAtDistance(const Block& sample, const size_t distance) {
+            if (sample.size() <= distance) return 1.0;
+            Block differences;
+            differences.reserve(sample.size()-distance);
+            for (size_t i=distance;i<sample.size();i++) differences.push_back(sample[i]-sample[i-distance]);
+            return BlockReport::getEntropy(BlockReport::getFrequencyArray(differences))/8;
+        }
+
+        /**
+         * Solves A x = b by gaussian elimination with partial pivoting, where A is n x n (row major)
+         */
+        std::vector<double> solveLinearSystem(std::vector<double> A, std::vector<double> b) {
+            const size_t n = b.size();
+            for (size_t column=0;column<n;column++) {
+                size_t pivot = column;
+                for (size_t row=column+1;row<n;row++)
+                    if (std::abs(A[row*n+column]) > std::abs(A[pivot*n+column])) pivot = row;
+                if (pivot != column) {
+                    for (size_t k=0;k<n;k++) std::swap(A[column*n+k], A[pivot*n+k]);
+                    std::swap(b[column], b[pivot]);
+                }
+                const double diagonal = A[column*n+column];
+                if (diagonal == 0) continue; //can't happen with a ridge
+                for (size_t row=column+1;row<n;row++) {
+                    const double factor = A[row*n+column]/diagonal;
+                    if (factor == 0) continue;
+                    for (size_t k=column;k<n;k++) A[row*n+k] -= factor*A[column*n+k];
+                    b[row] -= factor*b[column];
+                }
+            }
+
+            std::vector<double> x(n, 0.0);
+            for (size_t row=n;row-->0;) {
+                double accumulator = b[row];
+                for (size_t k=row+1;k<n;k++) accumulator -= A[row*n+k]*x[k];
+                x[row] = (A[row*n+row] == 0) ? 0 : accumulator/A[row*n+row];
+            }
+            return x;
+        }
+    }
+
+    SurrogateModel::Features SurrogateModel::getFeatures(const Block& sample) {
+        Features features{1.0, 1.0, 1.0, 1.0, 0.0};
+        if (sample.empty()) return features;
+        features[1] = BlockReport::getEntropy(BlockReport::getFrequencyArray(sample))/8;
+        features[2] = getEntropyAtDistance(sample, 1);
+        features[3] = getEntropyAtDistance(sample, 4);
+        size_t repeats = 0;
+        for (size_t i=1;i<sample.size();i++) repeats += sample[i] == sample[i-1];
+        features[4] = (double)repeats/sample.size();
+        return features;
+    }
+
+    std::array<double, SurrogateModel::weightAmount> SurrogateModel::getInputs(const Features& features, const Recipe& recipe) {
+        std::array<double, weightAmount> inputs{};
+        auto addCode = [&](const size_t code) {
+            for (size_t f=0;f<featureAmount;f++) inputs[code*featureAmount+f] += features[f];
+        };
+        addCode(recipe.cCode);
+        for (const TCode tCode: recipe.tList) addCode(cCodeAmount + tCode);
+        return inputs;
+    }
+
+    double SurrogateModel::predict(const Features& features, const Recipe& recipe) const {
+        //only the weights of the codes in the recipe are involved, so there's no need to build all the inputs
+        auto contributionOf = [&](const size_t code) {
+            double contribution = 0;
+            for (size_t f=0;f<featureAmount;f++) contribution += weights[code*featureAmount+f]*features[f];
+            return contribution;
+        };
+        double prediction = contributionOf(recipe.cCode);
+        for (const TCode tCode: recipe.tList) prediction += contributionOf(cCodeAmount + tCode);
+        return prediction;
+    }
+
+    bool SurrogateModel::save(const std::string& fileName) const {
+        std::ofstream outStream(fileName);
+        outStream << "EVOCOM_SURROGATE " << fileFormatVersion << " " << featureAmount << " " << cCodeAmount << " " << tCodeAmount << "\n";
+        outStream.precision(17);
+        auto writeCode = [&](const std::string& name, const size_t code) {
+            outStream << name;
+            for (size_t f=0;f<featureAmount;f++) outStream << " " << weights[code*featureAmount+f];
+            outStream << "\n";
+        };
+        for (size_t c=0;c<cCodeAmount;c++) writeCode(CCodesAsStrings[c], c);
+        for (size_t t=0;t<tCodeAmount;t++) writeCode(TCodesAsStrings[t], cCodeAmount+t);
+        return (bool)outStream;
+    }
+
+    std::optional<SurrogateModel> SurrogateModel::load(const std::string& fileName) {
+        std::ifstream inStream(fileName);
+        std::string magic;
+        int version = 0;
+        size_t features = 0, cCodes = 0, tCodes = 0;
+        inStream >> magic >> version >> features >> cCodes >> tCodes;
+        if (!inStream || magic != "EVOCOM_SURROGATE" || version != fileFormatVersion
+            || features != featureAmount || cCodes != cCodeAmount || tCodes != tCodeAmount)
+            return {};
+
+        Weights weights(weightAmount);
+        for (size_t code=0;code<cCodeAmount+tCodeAmount;code++) {
+            std::string name; //only there for whoever reads the file
+            inStream >> name;
+            for (size_t f=0;f<featureAmount;f++) inStream >> weights[code*featureAmount+f];
+        }
+        if (!inStream) return {};
+        return SurrogateModel(weights);
+    }
+
+    SurrogateModel::Trainer::Trainer() :
+        normalMatrix(weightAmount*weightAmount, 0.0),
+        normalVector(weightAmount, 0.0) {
+    }
+
+    void SurrogateModel::Trainer::addSample(const Features& features, const Recipe& recipe, const double fitness) {
+        const auto inputs = getInputs(features, recipe);
+        std::vector<size_t> used; //the inputs are sparse, only the codes in the recipe are non zero
+        for (size_t i=0;i<weightAmount;i++) if (inputs[i] != 0) used.push_back(i);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const size_t i: used) {
+            normalVector[i] += inputs[i]*fitness;
+            for (const size_t j: used) normalMatrix[i*weightAmount+j] += inputs[i]*inputs[j];
+        }
+        sampleAmount++;
+    }
+
+    SurrogateModel SurrogateModel::Trainer::fit(const double ridge) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<double> A = normalMatrix;
+        for (size_t i=0;i<weightAmount;i++) A[i*weightAmount+i] += ridge;
+        return SurrogateModel(solveLinearSystem(A, normalVector));
+    }
+
+} // GC
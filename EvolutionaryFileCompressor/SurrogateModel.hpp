@@ -0,0 +1,82 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_SURROGATEMODEL_HPP
+#define EVOCOM_SURROGATEMODEL_HPP
+
+#include "../names.hpp"
+#include "../Evolver/Recipe/Recipe.hpp"
+#include <array>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace GC {
+
+    /**
+     * A cheap estimate of the fitness of a recipe on a block, used by the Evaluator to skip the real evaluation of recipes which are obviously bad
+     * (eg SPLIT on high entropy data, or LZW on random bytes).
+     *
+     * It's linear: each compression code and each transform code has a weight for each feature of the block sample
+     * (entropy, entropy of the deltas, entropy at a distance of 4, how often a byte repeats the previous one),
+     * and the estimate is the sum of the contributions of the codes in the recipe.
+     * It's trained offline by a Trainer, which collects the real evaluations during a CompressionDataCollection run
+     * and fits the weights by ridge regression, and it's saved to / loaded from a small text file.
+     */
+    class SurrogateModel {
+    public:
+        static constexpr size_t featureAmount = 5; //including the constant 1
+        static constexpr size_t tCodeAmount = T_AmountOfTCodes;
+        static constexpr size_t cCodeAmount = C_AmountOfCCodes;
+        static constexpr size_t weightAmount = (tCodeAmount + cCodeAmount)*featureAmount;
+        static constexpr int fileFormatVersion = 1;
+
+        using Features = std::array<double, featureAmount>;
+        using Weights = std::vector<double>;
+
+        class Trainer {
+            std::vector<double> normalMatrix;    //X^T X, weightAmount x weightAmount
+            std::vector<double> normalVector;    //X^T y
+            size_t sampleAmount = 0;
+            mutable std::mutex mutex;
+
+        public:
+            Trainer();
+
+            void addSample(const Features& features, const Recipe& recipe, const double fitness);
+
+            size_t getSampleAmount() const {
+                std::lock_guard<std::mutex> lock(mutex);
+                return sampleAmount;
+            }
+
+            /**
+             * @param ridge keeps the weights of the codes which were rarely (or never) seen close to 0
+             */
+            SurrogateModel fit(const double ridge = 1e-3) const;
+        };
+
+    private:
+        Weights weights;
+
+        static std::array<double, weightAmount> getInputs(const Features& features, const Recipe& recipe);
+
+    public:
+        SurrogateModel() : weights(weightAmount, 0.0) {}
+        explicit SurrogateModel(const Weights& weights) : weights(weights) { ASSERT_EQUALS(weights.size(), weightAmount); }
+
+        static Features getFeatures(const Block& sample);
+
+        double predict(const Features& features, const Recipe& recipe) const;
+
+        const Weights& getWeights() const { return weights; }
+
+        bool save(const std::string& fileName) const;
+        static std::optional<SurrogateModel> load(const std::string& fileName);
+    };
+
+} // GC
+
+#endif //EVOCOM_SURROGATEMODEL_HPP
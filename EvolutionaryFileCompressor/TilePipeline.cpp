@@ -0,0 +1,384 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "TilePipeline.hpp"
+#include "../Utilities/utilities.hpp"
+#include "../Kernels/DeltaKernels.hpp"
+#include "../Kernels/OffsetKernels.hpp"
+#include "../Transformation/Transformations/StackTransform.hpp"
+#include "../Transformation/Transformations/SplitTransform.hpp"
+#include <array>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace GC {
+
+    namespace {
+
+        /**
+         * A transform which can be applied one tile at a time.
+         * encodeTile appends the output for the tile, finish appends whatever was held back for the end.
+         */
+        class StreamingStage {
+        public:
+            virtual ~StreamingStage() = default;
+
+            //forgets the state carried between tiles, but keeps the statistics
+            virtual void restart() = 0;
+
+            virtual void encodeTile(const Unit* tile, const size_t size, Block& output) = 0;
+
+            virtual void finish(Block& /*output*/) {}
+
+            virtual bool needsStatistics() const { return false; }
+
+            virtual void gatherStatistics(const Unit* /*tile*/, const size_t /*size*/) {}
+        };
+
+        inline Unit* appendSpace(Block& output, const size_t amount) {
+            const size_t oldSize = output.size();
+            output.resize(oldSize+amount);
+            return output.data()+oldSize;
+        }
+
+        class IdentityStage : public StreamingStage {
+        public:
+            void restart() override {}
+
+            void encodeTile(const Unit* tile, const size_t size, Block& output) override {
+                output.insert(output.end(), tile, tile+size);
+            }
+        };
+
+        //delta and xor delta, over words of laneSize units. The units after the last complete word are left as they are
+        class DeltaStage : public StreamingStage {
+        private:
+            const DeltaKernels::Kernel encode;
+            const size_t laneSize;
+            std::array<Unit, 8> previousWord;
+            std::array<Unit, 8> partialWord;
+            size_t partialSize;
+
+            void encodeWords(const Unit* words, const size_t size, Block& output) {
+                if (size == 0) return;
+                Unit* destination = appendSpace(output, size);
+                encode(words, destination, size);
+
+                //the kernel leaves the first word as it is, so it's redone against the last word of the previous tile
+                std::array<Unit, 16> pair;
+                std::memcpy(pair.data(), previousWord.data(), laneSize);
+                std::memcpy(pair.data()+laneSize, words, laneSize);
+                encode(pair.data(), pair.data(), 2*laneSize);
+                std::memcpy(destination, pair.data()+laneSize, laneSize);
+                std::memcpy(previousWord.data(), words+size-laneSize, laneSize);
+            }
+
+        public:
+            DeltaStage(const size_t laneSize, const bool isXOR) :
+                encode(isXOR ? getDeltaKernels(laneSize).xorEncode : getDeltaKernels(laneSize).deltaEncode),
+                laneSize(laneSize) {
+                restart();
+            }
+
+            void restart() override {
+                previousWord.fill(0); //so that the first word is unchanged
+                partialSize = 0;
+            }
+
+            void encodeTile(const Unit* tile, const size_t size, Block& output) override {
+                size_t used = 0;
+                if (partialSize > 0) {
+                    used = std::min(laneSize-partialSize, size);
+                    std::memcpy(partialWord.data()+partialSize, tile, used);
+                    partialSize += used;
+                    if (partialSize < laneSize) return;
+                    encodeWords(partialWord.data(), laneSize, output);
+                    partialSize = 0;
+                }
+                const size_t wordsSize = ((size-used)/laneSize)*laneSize;
+                encodeWords(tile+used, wordsSize, output);
+                used += wordsSize;
+                partialSize = size-used;
+                std::memcpy(partialWord.data(), tile+used, partialSize);
+            }
+
+            void finish(Block& output) override {
+                output.insert(output.end(), partialWord.begin(), partialWord.begin()+partialSize);
+            }
+        };
+
+        class SplitStage : public StreamingStage {
+        public:
+            void restart() override {}
+
+            void encodeTile(const Unit* tile, const size_t size, Block& output) override {
+                Unit* destination = appendSpace(output, size*2);
+                for (size_t i=0;i<size;i++) {
+                    destination[2*i] = tile[i]>>SplitTransform::bitsInEachSplit;
+                    destination[2*i+1] = ((Unit)(tile[i]<<SplitTransform::bitsInEachSplit))>>SplitTransform::bitsInEachSplit;
+                }
+            }
+        };
+
+        class StackStage : public StreamingStage {
+        private:
+            StackTransform::UnitTable table;
+        public:
+            StackStage() { restart(); }
+
+            void restart() override { table = StackTransform::getInitialTable(); }
+
+            void encodeTile(const Unit* tile, const size_t size, Block& output) override {
+                Unit* destination = appendSpace(output, size);
+                for (size_t i=0;i<size;i++)
+                    destination[i] = StackTransform::findInTableAndUpdate(tile[i], table);
+            }
+        };
+
+        //SubtractAverageTransform and SubtractXORAverageTransform: [average][units - average]
+        class AverageStage : public StreamingStage {
+        private:
+            const bool isXOR;
+            size_t count = 0;
+            size_t sum = 0;
+            std::array<size_t, bitsInType<Unit>()> oneCounts = {};
+            bool isHeaderWritten = false;
+
+            Unit getAverage() const {
+                if (count == 0) return 0;
+                if (!isXOR)
+                    return (Unit)((double)sum / count); //the same as StatisticalFeatures::getAverage
+                Unit result = 0;
+                for (size_t bit=0;bit<oneCounts.size();bit++)    //the same as BlockReport::getXorAverage
+                    result |= (oneCounts[bit] > count/2) << bit;
+                return result;
+            }
+
+        public:
+            explicit AverageStage(const bool isXOR) : isXOR(isXOR) {}
+
+            bool needsStatistics() const override { return true; }
+
+            void gatherStatistics(const Unit* tile, const size_t size) override {
+                count += size;
+                for (size_t i=0;i<size;i++) {
+                    sum += tile[i];
+                    if (isXOR)
+                        for (size_t bit=0;bit<oneCounts.size();bit++)
+                            oneCounts[bit] += (tile[i]>>bit)&1;
+                }
+            }
+
+            void restart() override { isHeaderWritten = false; }
+
+            void encodeTile(const Unit* tile, const size_t size, Block& output) override {
+                const Unit average = getAverage();
+                if (!isHeaderWritten) {
+                    output.push_back(average);
+                    isHeaderWritten = true;
+                }
+                Unit* destination = appendSpace(output, size);
+                for (size_t i=0;i<size;i++)
+                    destination[i] = isXOR ? (tile[i] ^ average) : (Unit)(tile[i] - average);
+            }
+
+            void finish(Block& output) override {
+                if (!isHeaderWritten) output.push_back(getAverage());
+            }
+        };
+
+        /**
+         * SubMinAdaptiveTransform, where the units of the current subsegment are held back until it ends.
+         * Whether a subsegment ends at i depends on the units in [i-3, i+3], and it can only end when i-start >= minSegmentSize,
+         * so the held back units (from the start of the subsegment) are always enough to carry on the scan in the next tile.
+         */
+        class SubMinAdaptiveStage : public StreamingStage {
+        private: //the same constants as SubMinAdaptiveTransform
+            static constexpr size_t peekDistance = 3;
+            static constexpr size_t threshold = 3;
+            static constexpr size_t minSegmentSize = 4;
+            static constexpr size_t maxSegmentSize = 254;
+
+            const OffsetKernels& kernels;
+            Block pending;          //the units from the start of the current subsegment
+            size_t scanned;         //the units of pending which have been scanned, ie their minimum is in currentMinimum
+            Unit currentMinimum;
+            bool hasReceivedUnits;
+
+            void emitSubsegment(const size_t start, const size_t end, const Unit minimum, const bool isLast, Unit* destination) {
+                destination[0] = minimum;
+                destination[1] = isLast ? 0 : (end-start);
+                kernels.subtractOffset(pending.data()+start, destination+2, end-start, minimum);
+            }
+
+        public:
+            SubMinAdaptiveStage() : kernels(getOffsetKernels()) { restart(); }
+
+            void restart() override {
+                pending.clear();
+                scanned = 0;
+                currentMinimum = highestUnsignedValue<Unit>();
+                hasReceivedUnits = false;
+            }
+
+            void encodeTile(const Unit* tile, const size_t size, Block& output) override {
+                hasReceivedUnits = hasReceivedUnits || (size > 0);
+                pending.insert(pending.end(), tile, tile+size);
+
+                //everything is kept in locals, since the writes to the output could alias the members
+                const Unit* data = pending.data();
+                const size_t available = pending.size();
+                auto windowMinimum = [&](const size_t index) -> Unit {
+                    return std::min(std::min(data[index], data[index+1]), std::min(data[index+2], data[index+3]));
+                };
+
+                //the window minimums of the last units scanned in the previous tile (only those inside the subsegment are ever compared)
+                Unit recentWindowMinimums[peekDistance+1];
+                size_t i = scanned;
+                for (size_t j = (i > peekDistance) ? i-peekDistance : 0; j < i; j++)
+                    recentWindowMinimums[j%(peekDistance+1)] = windowMinimum(j);
+
+                const size_t oldSize = output.size();
+                output.resize(oldSize + available + 2*(available/(minSegmentSize+1)+1));
+                size_t writeIndex = oldSize;
+
+                size_t start = 0;
+                Unit minimum = currentMinimum;
+                for (; i+peekDistance < available; i++) {
+                    recentWindowMinimums[i%(peekDistance+1)] = windowMinimum(i);
+                    minimum = std::min(minimum, data[i]);
+                    if (!isInInterval_inclusive(i-start, minSegmentSize, maxSegmentSize)) continue;
+                    const Unit before = recentWindowMinimums[(i-peekDistance)%(peekDistance+1)];
+                    if (safeAbsDifference(before, recentWindowMinimums[i%(peekDistance+1)]) >= threshold) {
+                        emitSubsegment(start, i+1, minimum, false, output.data()+writeIndex);
+                        writeIndex += i+1-start+2;
+                        start = i+1;
+                        minimum = highestUnsignedValue<Unit>();
+                    }
+                }
+                output.resize(writeIndex);
+                currentMinimum = minimum;
+                pending.erase(pending.begin(), pending.begin()+start);
+                scanned = i-start;
+            }
+
+            void finish(Block& output) override {
+                if (!hasReceivedUnits) return;
+                currentMinimum = std::min(currentMinimum, kernels.minimum(pending.data()+scanned, pending.size()-scanned));
+                emitSubsegment(0, pending.size(), currentMinimum, true, appendSpace(output, pending.size()+2));
+            }
+        };
+
+        std::unique_ptr<StreamingStage> makeStage(const TCode tCode) {
+            switch (tCode) {
+                case T_IdentityTransform:           return std::make_unique<IdentityStage>();
+                case T_DeltaTransform:              return std::make_unique<DeltaStage>(1, false);
+                case T_DeltaXORTransform:           return std::make_unique<DeltaStage>(1, true);
+                case T_DeltaTransform_16:           return std::make_unique<DeltaStage>(2, false);
+                case T_DeltaTransform_32:           return std::make_unique<DeltaStage>(4, false);
+                case T_DeltaTransform_64:           return std::make_unique<DeltaStage>(8, false);
+                case T_DeltaXORTransform_16:        return std::make_unique<DeltaStage>(2, true);
+                case T_DeltaXORTransform_32:        return std::make_unique<DeltaStage>(4, true);
+                case T_DeltaXORTransform_64:        return std::make_unique<DeltaStage>(8, true);
+                case T_SplitTransform:              return std::make_unique<SplitStage>();
+                case T_StackTransform:              return std::make_unique<StackStage>();
+                case T_SubtractAverageTransform:    return std::make_unique<AverageStage>(false);
+                case T_SubtractXORAverageTransform: return std::make_unique<AverageStage>(true);
+                case T_SubMinAdaptiveTransform:     return std::make_unique<SubMinAdaptiveStage>();
+                default: ERROR_NOT_IMPLEMENTED("This transform can't be streamed");
+            }
+            return nullptr;
+        }
+
+        /**
+         * Streams the input through the first amount stages, and gives the resulting tiles to the sink.
+         * Every stage writes into its own tile buffer, which is reused for all of the tiles.
+         */
+        template <class Sink>
+        void streamThrough(std::vector<std::unique_ptr<StreamingStage>>& stages, const size_t amount,
+                           std::vector<Block>& tileBuffers, const Block& input, const size_t tileSize, Sink&& sink) {
+            std::function<void(size_t, const Unit*, size_t)> push = [&](const size_t which, const Unit* data, const size_t size) {
+                if (which == amount) {
+                    sink(data, size);
+                    return;
+                }
+                Block& buffer = tileBuffers[which];
+                buffer.clear();
+                stages[which]->encodeTile(data, size, buffer);
+                push(which+1, buffer.data(), buffer.size());
+            };
+
+            for (size_t i=0;i<amount;i++)
+                stages[i]->restart();
+
+            for (size_t start=0;start<input.size();start+=tileSize)
+                push(0, input.data()+start, std::min(tileSize, input.size()-start));
+
+            //each stage has to finish after the ones before it, since they might still give it some units
+            for (size_t i=0;i<amount;i++) {
+                Block& buffer = tileBuffers[i];
+                buffer.clear();
+                stages[i]->finish(buffer);
+                push(i+1, buffer.data(), buffer.size());
+            }
+        }
+    }
+
+    bool TilePipeline::isStreamable(const TCode tCode) {
+        switch (tCode) {
+            case T_IdentityTransform:
+            case T_DeltaTransform:
+            case T_DeltaXORTransform:
+            case T_DeltaTransform_16:
+            case T_DeltaTransform_32:
+            case T_DeltaTransform_64:
+            case T_DeltaXORTransform_16:
+            case T_DeltaXORTransform_32:
+            case T_DeltaXORTransform_64:
+            case T_SplitTransform:
+            case T_StackTransform:
+            case T_SubtractAverageTransform:
+            case T_SubtractXORAverageTransform:
+            case T_SubMinAdaptiveTransform:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    size_t TilePipeline::streamableRunEnd(const TCode* tCodes, const size_t amount, const size_t start) {
+        auto needsStatistics = [](const TCode tCode) {
+            return tCode == T_SubtractAverageTransform || tCode == T_SubtractXORAverageTransform;
+        };
+        //a transform that needs statistics starts a new run, so that they're read from its materialised input rather than recomputed
+        size_t end = start;
+        while (end < amount && isStreamable(tCodes[end]) && (end == start || !needsStatistics(tCodes[end])))
+            end++;
+        return end;
+    }
+
+    void TilePipeline::apply(const TCode* tCodes, const size_t amount, const Block& input, Block& output, const size_t tileSize) {
+        std::vector<std::unique_ptr<StreamingStage>> stages;
+        for (size_t i=0;i<amount;i++)
+            stages.push_back(makeStage(tCodes[i]));
+        std::vector<Block> tileBuffers(amount);
+
+        for (size_t i=0;i<amount;i++) {
+            if (!stages[i]->needsStatistics()) continue;
+            StreamingStage& stage = *stages[i];
+            streamThrough(stages, i, tileBuffers, input, tileSize, [&](const Unit* data, const size_t size) {
+                stage.gatherStatistics(data, size);
+            });
+        }
+
+        output.clear();
+        output.reserve(input.size());
+        streamThrough(stages, amount, tileBuffers, input, tileSize, [&](const Unit* data, const size_t size) {
+            output.insert(output.end(), data, data+size);
+        });
+    }
+
+} // GC
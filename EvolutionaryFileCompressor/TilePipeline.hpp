@@ -0,0 +1,43 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_TILEPIPELINE_HPP
+#define EVOCOM_TILEPIPELINE_HPP
+
+#include "../names.hpp"
+#include "../Utilities/utilities.hpp"
+#include "../Evolver/Recipe/TCodes.hpp"
+
+namespace GC {
+
+    /**
+     * Applies a run of local transforms (delta, xor delta, lane deltas, split, stack, subtract (xor) average, subtract minimum adaptive)
+     * by pushing tiles of the input through all of them, instead of materialising the whole block after each transform.
+     * Each stage carries its state (the previous word, the move to front table, the unfinished subsegment..) from one tile to the next,
+     * so the output is the same as applying the transforms one after the other.
+     *
+     * The average transforms need a statistic of their whole input before writing anything:
+     * that's gathered by a first pass which streams the input through the stages before them, without storing the result.
+     * Since that repeats the work of those stages, streamableRunEnd starts a new run at an average transform instead.
+     *
+     * Global transforms (BWT, stride, LZW, RLE, block sorting) can't be streamed, so they end a run.
+     */
+    class TilePipeline {
+    public:
+        static constexpr size_t defaultTileSize = 64*1024;
+
+        static bool isStreamable(const TCode tCode);
+
+        /**
+         * @return the end of the run of streamable transforms starting at start (which is start itself if that transform is global)
+         */
+        static size_t streamableRunEnd(const TCode* tCodes, const size_t amount, const size_t start);
+
+        static void apply(const TCode* tCodes, const size_t amount, const Block& input, Block& output,
+                          const size_t tileSize = defaultTileSize);
+    };
+
+} // GC
+
+#endif //EVOCOM_TILEPIPELINE_HPP
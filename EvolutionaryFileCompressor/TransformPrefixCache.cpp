@@ -0,0 +1,71 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "TransformPrefixCache.hpp"
+
+namespace GC {
+
+    void TransformPrefixCache::markAsUsed(Node* node) {
+        leastRecentlyUsed.splice(leastRecentlyUsed.begin(), leastRecentlyUsed, node->positionInLRU);
+    }
+
+    void TransformPrefixCache::evictUntilWithinCapacity() {
+        while (storedBytes > capacityInBytes && !leastRecentlyUsed.empty()) {
+            Node* evicted = leastRecentlyUsed.back();
+            leastRecentlyUsed.pop_back();
+            storedBytes -= evicted->block.size();
+            evicted->block = Block(); //releases the memory, clear() would keep it
+            evicted->hasBlock = false;
+            statistics.evictions++;
+        }
+    }
+
+    size_t TransformPrefixCache::copyLongestPrefix(const TList& tList, Block& destination) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Node* current = &root;
+        Node* deepestWithBlock = nullptr;
+        size_t deepestLength = 0;
+        for (size_t i=0;i<tList.size();i++) {
+            const auto child = current->children.find(tList[i]);
+            if (child == current->children.end()) break;
+            current = child->second.get();
+            if (current->hasBlock) {
+                deepestWithBlock = current;
+                deepestLength = i+1;
+            }
+        }
+
+        statistics.transformsReused += deepestLength;
+        if (deepestWithBlock == nullptr) return 0;
+        markAsUsed(deepestWithBlock);
+        destination = deepestWithBlock->block;
+        return deepestLength;
+    }
+
+    void TransformPrefixCache::store(const TList& tList, const size_t prefixLength, const Block& block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (block.size() > capacityInBytes) return;
+
+        Node* current = &root;
+        for (size_t i=0;i<prefixLength;i++) {
+            std::unique_ptr<Node>& child = current->children[tList[i]];
+            if (!child) child = std::make_unique<Node>();
+            current = child.get();
+        }
+
+        if (current->hasBlock) {
+            storedBytes -= current->block.size();
+            markAsUsed(current);
+        }
+        else {
+            leastRecentlyUsed.push_front(current);
+            current->positionInLRU = leastRecentlyUsed.begin();
+            current->hasBlock = true;
+        }
+        current->block = block;
+        storedBytes += block.size();
+        evictUntilWithinCapacity();
+    }
+
+} // GC
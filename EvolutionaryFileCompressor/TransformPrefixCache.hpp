@@ -0,0 +1,93 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_TRANSFORMPREFIXCACHE_HPP
+#define EVOCOM_TRANSFORMPREFIXCACHE_HPP
+
+#include "../names.hpp"
+#include "../Evolver/Recipe/Recipe.hpp"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace GC {
+
+    /**
+     * Stores the intermediate blocks obtained while evaluating recipes on the same block, in a trie indexed by the transforms.
+     * Since many recipes in a population share their first transforms (BWTra.., STRD4, DELTA..),
+     * evaluating a recipe only has to apply the transforms after the longest prefix that's already stored.
+     *
+     * The stored blocks are bounded by capacityInBytes: when it's exceeded, the least recently used blocks are dropped
+     * (their trie nodes stay, they're tiny and they might get a block again later).
+     *
+     * The cache can be shared by the threads evaluating a generation: every method takes a lock,
+     * which is why a stored block is copied out rather than referenced.
+     */
+    class TransformPrefixCache {
+    public:
+        using TList = Recipe::TList;
+        static constexpr size_t defaultCapacityInBytes = 8*1024*1024;
+
+        struct Statistics {
+            size_t transformsReused = 0;   //transforms which didn't have to be applied, because their result was stored
+            size_t transformsApplied = 0;
+            size_t evictions = 0;
+        };
+
+    private:
+        struct Node {
+            std::unordered_map<TCode, std::unique_ptr<Node>> children;
+            Block block;
+            bool hasBlock = false;
+            std::list<Node*>::iterator positionInLRU;
+        };
+
+        Node root;
+        std::list<Node*> leastRecentlyUsed; //the front is the most recently used
+        size_t capacityInBytes;
+        size_t storedBytes = 0;
+        Statistics statistics;
+        mutable std::mutex mutex;
+
+        void markAsUsed(Node* node);
+        void evictUntilWithinCapacity();
+
+    public:
+        explicit TransformPrefixCache(const size_t capacityInBytes = defaultCapacityInBytes) :
+            capacityInBytes(capacityInBytes) {}
+
+        TransformPrefixCache(const TransformPrefixCache&) = delete;
+        TransformPrefixCache& operator=(const TransformPrefixCache&) = delete;
+
+        /**
+         * Copies the block of the longest prefix of tList which has one into destination (which is untouched if there's none)
+         * @return the length of that prefix, 0 if there's none
+         */
+        size_t copyLongestPrefix(const TList& tList, Block& destination);
+
+        /**
+         * Stores the result of applying the first prefixLength transforms of tList
+         */
+        void store(const TList& tList, const size_t prefixLength, const Block& block);
+
+        void registerAppliedTransform() {
+            std::lock_guard<std::mutex> lock(mutex);
+            statistics.transformsApplied++;
+        }
+
+        Statistics getStatistics() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return statistics;
+        }
+
+        size_t getStoredBytes() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return storedBytes;
+        }
+    };
+
+} // GC
+
+#endif //EVOCOM_TRANSFORMPREFIXCACHE_HPP
@@ -0,0 +1,48 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "WarmStartBoard.hpp"
+#include <cmath>
+#include <limits>
+
+namespace GC {
+
+    WarmStartBoard::Signature WarmStartBoard::makeSignature(const Block& sample) {
+        Signature signature{};
+        for (const Unit unit: sample) signature[unit >> 4]++;
+        if (!sample.empty())
+            for (double& bucket: signature) bucket /= sample.size();
+        return signature;
+    }
+
+    double WarmStartBoard::distanceBetween(const Signature& A, const Signature& B) {
+        double distance = 0;
+        for (size_t i=0;i<A.size();i++) distance += std::abs(A[i]-B[i]);
+        return distance;
+    }
+
+    std::vector<Recipe> WarmStartBoard::findHint(const Block& sample) const {
+        const Signature signature = makeSignature(sample);
+        std::lock_guard<std::mutex> lock(mutex);
+        const Entry* mostSimilar = nullptr;
+        double smallestDistance = std::numeric_limits<double>::max();
+        for (const Entry& entry: entries) {
+            const double distance = distanceBetween(signature, entry.signature);
+            if (distance <= smallestDistance) {
+                smallestDistance = distance;
+                mostSimilar = &entry;
+            }
+        }
+        return mostSimilar ? mostSimilar->elite : std::vector<Recipe>();
+    }
+
+    void WarmStartBoard::publish(const Block& sample, const std::vector<Recipe>& elite) {
+        if (elite.empty()) return;
+        Entry entry{makeSignature(sample), elite};
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.push_back(std::move(entry));
+        if (entries.size() > maxEntries) entries.pop_front();
+    }
+
+} // GC
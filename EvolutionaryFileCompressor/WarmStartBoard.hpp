@@ -0,0 +1,62 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_WARMSTARTBOARD_HPP
+#define EVOCOM_WARMSTARTBOARD_HPP
+
+#include "../names.hpp"
+#include "../Evolver/Recipe/Recipe.hpp"
+#include <array>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace GC {
+
+    /**
+     * Remembers the elite of the segments evolved so far in a file, so that the next segments can start from the elite of the most similar one
+     * (adjacent segments usually want similar recipes, and so do the segments in the same cluster).
+     *
+     * The similarity is the distance between the histograms of the high nibbles of the samples, which is cheap and tells apart text, images, tables etc.
+     * In the sequential modes the segments are published in order, so the hint for a segment is deterministic.
+     * In the asynchronous mode a segment only sees the segments which have finished when it starts.
+     */
+    class WarmStartBoard {
+    public:
+        using Signature = std::array<double, 16>;
+        static constexpr size_t maxEntries = 64; //the oldest are forgotten, so a lookup is bounded
+
+    private:
+        struct Entry {
+            Signature signature;
+            std::vector<Recipe> elite;
+        };
+
+        std::deque<Entry> entries;
+        mutable std::mutex mutex;
+
+        static double distanceBetween(const Signature& A, const Signature& B);
+
+    public:
+        static Signature makeSignature(const Block& sample);
+
+        /**
+         * @return the elite of the most similar segment (the latest one among equally similar ones), empty if there's none yet
+         */
+        std::vector<Recipe> findHint(const Block& sample) const;
+
+        /**
+         * The best recipe should be first, since it's the one which Evolver compares against
+         */
+        void publish(const Block& sample, const std::vector<Recipe>& elite);
+
+        size_t size() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return entries.size();
+        }
+    };
+
+} // GC
+
+#endif //EVOCOM_WARMSTARTBOARD_HPP
@@ -0,0 +1,82 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "BeamSearcher.hpp"
+#include <algorithm>
+#include <numeric>
+
+namespace GC {
+
+    BeamSearcher::BeamSearcher(const Evolver::EvolutionSettings& settings, const FitnessFunction& fitnessFunction) :
+        beamWidth(std::max<size_t>(settings.beamWidth, 1)),
+        depth(std::min({settings.beamDepth, settings.maxTransformAmount, TList::capacity})),
+        minTransformAmount(settings.minTransformAmount),
+        evaluationBudget(settings.evaluationBudget),
+        deadline(settings.timeBudget ? std::optional<Clock::time_point>(Clock::now() + *settings.timeBudget) : std::nullopt),
+        evaluator(fitnessFunction, settings.evaluationThreads) {
+        if (settings.keepsEvaluationLog) evaluator.keepEvaluationLog();
+    }
+
+    std::vector<BeamSearcher::Fitness> BeamSearcher::evaluateWithEveryCompression(const std::vector<TList>& chains) {
+        std::vector<Recipe> recipes;
+        recipes.reserve(chains.size()*availableCCodes.size());
+        for (const TList& chain: chains)
+            for (const CCode cCode: availableCCodes) recipes.emplace_back(chain, cCode);
+        evaluator.forceEvaluations(recipes);
+
+        std::vector<Fitness> bestOfChain(chains.size(), std::numeric_limits<Fitness>::max());
+        for (size_t i=0;i<recipes.size();i++) {
+            Fitness& best = bestOfChain[i / availableCCodes.size()];
+            best = std::min(best, recipes[i].getFitness());
+        }
+        evaluated.insert(evaluated.end(), recipes.begin(), recipes.end());
+        return bestOfChain;
+    }
+
+    bool BeamSearcher::isOutOfBudget() const {
+        if (evaluationBudget > 0 && evaluator.getCacheStatistics().misses >= evaluationBudget) return true;
+        return deadline && Clock::now() >= *deadline;
+    }
+
+    Recipe BeamSearcher::searchBest() {
+        std::vector<TList> beam{TList()};
+        evaluateWithEveryCompression(beam);
+
+        for (size_t level=1;level<=depth && !isOutOfBudget();level++) {
+            std::vector<TList> extensions;
+            extensions.reserve(beam.size()*availableTCodes.size());
+            for (const TList& chain: beam)
+                for (const TCode tCode: availableTCodes) {
+                    if (tCode == T_IdentityTransform) continue; //it would only make the recipe longer
+                    TList extension = chain;
+                    extension.push_back(tCode);
+                    extensions.push_back(extension);
+                }
+
+            const std::vector<Fitness> scores = evaluateWithEveryCompression(extensions);
+            std::vector<size_t> ranking(extensions.size());
+            std::iota(ranking.begin(), ranking.end(), 0);
+            std::stable_sort(ranking.begin(), ranking.end(), [&](const size_t A, const size_t B) { return scores[A] < scores[B]; });
+
+            beam.clear();
+            for (size_t i=0;i<std::min(beamWidth, ranking.size());i++) beam.push_back(extensions[ranking[i]]);
+            levelsSearched = level;
+        }
+
+        const Recipe* best = nullptr;
+        for (const Recipe& recipe: evaluated) {
+            if (recipe.getTListLength() < minTransformAmount) continue;
+            if (best == nullptr || recipe.getFitness() < best->getFitness()) best = &recipe;
+        }
+        return best ? *best : evaluated.front(); //when minTransformAmount is out of reach, the empty chain will do
+    }
+
+    std::vector<Recipe> BeamSearcher::getElite(const size_t amount) const {
+        std::vector<Recipe> sorted = evaluated;
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Recipe& A, const Recipe& B) { return A.getFitness() < B.getFitness(); });
+        sorted.resize(std::min(amount, sorted.size()));
+        return sorted;
+    }
+
+} // GC
@@ -0,0 +1,76 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_BEAMSEARCHER_HPP
+#define EVOCOM_BEAMSEARCHER_HPP
+
+#include "../Evolver.hpp"
+#include <chrono>
+#include <optional>
+
+namespace GC {
+
+    /**
+     * A deterministic alternative to the Evolver, for when the search space is small enough (short recipes on small segments).
+     *
+     * The transform chains are expanded level by level: every chain in the beam is extended by every transform,
+     * every extension is evaluated with every compression code (its score is the best of those),
+     * and the beamWidth best extensions make up the beam of the next level.
+     * When the fitness function goes through a TransformPrefixCache, an extension only applies its last transform to the block of its parent.
+     *
+     * The search stops after beamDepth levels (or maxTransformAmount, when it's smaller),
+     * or when the evaluation budget or the time budget has run out (they're checked between levels).
+     */
+    class BeamSearcher {
+    public:
+        using FitnessFunction = Evaluator::FitnessFunction;
+        using Fitness = Recipe::FitnessScore;
+        using TList = Recipe::TList;
+        using Clock = std::chrono::steady_clock;
+
+    private:
+        const size_t beamWidth;
+        const size_t depth;
+        const size_t minTransformAmount;
+        const size_t evaluationBudget;
+        const std::optional<Clock::time_point> deadline;
+
+        Evaluator evaluator;
+        std::vector<Recipe> evaluated; //in the order they were evaluated
+        size_t levelsSearched = 0;
+
+        /**
+         * @return for each chain, the best fitness among the compression codes
+         */
+        std::vector<Fitness> evaluateWithEveryCompression(const std::vector<TList>& chains);
+
+        bool isOutOfBudget() const;
+
+    public:
+        BeamSearcher(const Evolver::EvolutionSettings& settings, const FitnessFunction& fitnessFunction);
+
+        /**
+         * @return the best recipe found, the earliest evaluated among equally good ones
+         */
+        Recipe searchBest();
+
+        /**
+         * @return the best evaluated recipes, best first
+         */
+        std::vector<Recipe> getElite(const size_t amount) const;
+
+        const Evaluator::CacheStatistics& getFitnessCacheStatistics() const {
+            return evaluator.getCacheStatistics();
+        }
+
+        const std::vector<Evaluator::Evaluation>& getEvaluationLog() const {
+            return evaluator.getEvaluationLog();
+        }
+
+        size_t getLevelsSearched() const { return levelsSearched; }
+    };
+
+} // GC
+
+#endif //EVOCOM_BEAMSEARCHER_HPP
@@ -102,8 +102,8 @@ namespace GC {
         }
 
         void mutateElements(Recipe& individual) {
-            for (TCode& tCode : individual.getTList())
-                randomChanceOfMutation.doWithChance([&]{randomTCode.assignRandomValue(tCode);});
+            for (size_t i=0;i<individual.getTListLength();i++)
+                randomChanceOfMutation.doWithChance([&]{individual.setTItem(randomTCode.choose(), i);});
         }
 
         void mutateCCode(Recipe& individual) {
@@ -240,9 +240,8 @@ namespace GC {
             }
 
             Recipe makeIndividual() {
-                Recipe::TList tList(randomLength.choose());
-                for (TCode& tCode: tList)
-                    randomTCode.assignRandomValue(tCode);
+                Recipe::TList tList;
+                repeat(randomLength.choose(), [&](){tList.push_back(randomTCode.choose());});
                 CCode cCode = randomCCode.choose();
                 return Recipe(tList, cCode);
             }
@@ -8,8 +8,15 @@
 #include "../PseudoFitness/PseudoFitness.hpp"
 #include "../Recipe/Recipe.hpp"
 #include "../../Random/RandomChance.hpp"
+#include "../../Utilities/ThreadPool/ThreadPool.hpp"
 #include <sstream>
 #include <iomanip>
+#include <unordered_map>
+#include <memory>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
 
 namespace GC {
 
@@ -19,12 +26,71 @@ namespace GC {
         using Reliability = PseudoFitness::Reliability;
         using Similarity = PseudoFitness::Similarity;
         using FitnessFunction = std::function<FitnessScore(Recipe)>;
+        using Surrogate = std::function<FitnessScore(const Recipe&)>; //a cheap estimate of the fitness function
+        using Evaluation = std::pair<Recipe, FitnessScore>;
+
+        /**
+         * How many of the requested evaluations actually called the fitness function.
+         * hits were found in the cache, skipped already had an actual fitness, misses had to be evaluated,
+         * screened were given the estimate of the surrogate instead, because it was clearly worse than the best so far,
+         * lowFidelity were only scored with the low fidelity fitness function, because they weren't promoted.
+         */
+        struct CacheStatistics {
+            size_t hits = 0;
+            size_t skipped = 0;
+            size_t misses = 0;
+            size_t screened = 0;
+            size_t lowFidelity = 0;
+
+            size_t getRequests() const { return hits+skipped+misses+screened+lowFidelity; }
+
+            CacheStatistics& operator+=(const CacheStatistics& other) {
+                hits += other.hits;
+                skipped += other.skipped;
+                misses += other.misses;
+                screened += other.screened;
+                lowFidelity += other.lowFidelity;
+                return *this;
+            }
+
+            double getHitRate() const {
+                const size_t requests = getRequests();
+                return (requests == 0) ? 0.0 : (double)(hits+skipped)/requests;
+            }
+
+            std::string to_string() const {
+                std::stringstream ss;
+                ss<<"{FitnessCache: hits="<<hits<<", skipped="<<skipped<<", misses="<<misses;
+                if (screened > 0) ss<<", screened="<<screened;
+                if (lowFidelity > 0) ss<<", lowFidelity="<<lowFidelity;
+                ss<<", hitRate="<<std::setprecision(2)<<getHitRate()<<"}";
+                return ss.str();
+            }
+        };
 
     private:
         Reliability reliabilityThreshold; //what is the minimum accepted reliability? (always in [0, 1])
         mutable RandomChance randomEvaluationChooser;
         FitnessFunction fitnessFunction;
 
+        //the fitness function is deterministic for a given block, and an evaluator only ever sees one block
+        mutable std::unordered_map<Recipe, FitnessScore> fitnessCache;
+        mutable CacheStatistics cacheStatistics;
+
+        //the actual evaluations of a batch are spread over these threads, so the fitness function has to be thread safe when there's more than one
+        std::unique_ptr<ThreadPool> threadPool;
+
+        Surrogate surrogate;                  //empty when there's none
+        FitnessScore surrogateMargin = 0;     //how much worse than the best actual fitness an estimate has to be for the evaluation to be skipped
+        static constexpr Reliability screenedReliability = 0.5; //below the threshold, so the children of a screened recipe are evaluated
+        mutable FitnessScore bestActualFitness = std::numeric_limits<FitnessScore>::max();
+
+        FitnessFunction lowFidelityFitnessFunction; //a cheaper version of the fitness function (eg on a smaller sample), empty when there's none
+        double promotedProportion = 1;              //of a batch scored with it, the best this proportion get an actual evaluation
+
+        bool keepsEvaluationLog = false;
+        mutable std::vector<Evaluation> evaluationLog; //the actual evaluations, in the order of the individuals of each batch
+
         Similarity getSimilarity(const Recipe& A, const Recipe& B) const { //1 means they're identical
             const auto elemsIn = [&](const Recipe& i) {
                 return i.getTListLength()+1; //+1 is because there's the compression
@@ -85,26 +151,206 @@ namespace GC {
         }
 
 
+        void setActualFitness(Recipe& I, const FitnessScore f) const {
+            setFitnessScore(I, f);
+            setReliability(I, 1.0);
+            bestActualFitness = std::min(bestActualFitness, f);
+        }
+
+
     public:
-        Evaluator(const FitnessFunction fitnessFunction) :
+        Evaluator(const FitnessFunction fitnessFunction, const size_t evaluationThreads = 1) :
             fitnessFunction(fitnessFunction),
             reliabilityThreshold(0.8),
-            randomEvaluationChooser(0.05){
+            randomEvaluationChooser(0.05),
+            threadPool(std::make_unique<ThreadPool>(evaluationThreads)){
         }
 
-        void decideFitness(Recipe& child, const Recipe& A, const Recipe& B) {
+        /**
+         * Gives the child the fitness inherited from its parents.
+         * @return whether the child also needs an actual evaluation (the inherited fitness is unreliable, or it was randomly chosen)
+         */
+        bool inheritFitness(Recipe& child, const Recipe& A, const Recipe& B) {
             assignInheritedFitnessToChild(child, A, B);
             //LOG("A's reliability=", A.getFitnessReliability(), "B's reliability=", B.getFitnessReliability());
-            if (reliabilityTooLow(child) || randomEvaluationChooser.shouldDo()) {
+            return reliabilityTooLow(child) || randomEvaluationChooser.shouldDo();
+        }
+
+        void decideFitness(Recipe& child, const Recipe& A, const Recipe& B) {
+            if (inheritFitness(child, A, B)) {
                 forceEvaluation(child);
             }
-
         }
 
 
         void forceEvaluation(Recipe& I) const {
-            setFitnessScore(I, fitnessFunction(I));
-            setReliability(I, 1.0);
+            forceEvaluations({&I});
+        }
+
+        /**
+         * Gives an actual fitness to all of the individuals, calling the fitness function in parallel for the ones which are not in the cache.
+         * The cache and the statistics are only touched by the calling thread, in the order of the individuals,
+         * so the outcome is the same as calling forceEvaluation on each of them, whatever the amount of threads.
+         */
+        void forceEvaluations(const std::vector<Recipe*>& individuals) const {
+            std::vector<Recipe*> toEvaluate;                     //the first occurrence of each recipe that's neither assessed nor cached
+            std::unordered_map<Recipe, size_t> positionInBatch;  //where each of those is in toEvaluate
+            std::vector<std::pair<Recipe*, size_t>> repeats;     //later occurrences, they get the fitness of the first one
+
+            for (Recipe* I: individuals) {
+                if (I->isFitnessAssessed()) {
+                    cacheStatistics.skipped++;
+                    continue;
+                }
+
+                const auto cached = fitnessCache.find(*I);
+                if (cached != fitnessCache.end()) {
+                    cacheStatistics.hits++;
+                    setActualFitness(*I, cached->second);
+                    continue;
+                }
+
+                const auto [position, isNew] = positionInBatch.emplace(*I, toEvaluate.size());
+                if (isNew) {
+                    cacheStatistics.misses++;
+                    toEvaluate.push_back(I);
+                }
+                else {
+                    cacheStatistics.hits++; //when evaluated one by one, it would have been found in the cache
+                    repeats.emplace_back(I, position->second);
+                }
+            }
+
+            std::vector<FitnessScore> fitnesses(toEvaluate.size());
+            threadPool->forEachIndex(toEvaluate.size(), [&](const size_t i) {
+                fitnesses[i] = fitnessFunction(*toEvaluate[i]);
+            });
+
+            for (size_t i=0;i<toEvaluate.size();i++) {
+                fitnessCache.emplace(*toEvaluate[i], fitnesses[i]);
+                setActualFitness(*toEvaluate[i], fitnesses[i]);
+                if (keepsEvaluationLog) evaluationLog.emplace_back(*toEvaluate[i], fitnesses[i]);
+            }
+            for (const auto& [I, position]: repeats)
+                setActualFitness(*I, fitnesses[position]);
+        }
+
+        void forceEvaluations(std::vector<Recipe>& individuals, const std::vector<size_t>& indexes) const {
+            std::vector<Recipe*> selected;
+            selected.reserve(indexes.size());
+            for (const size_t index: indexes) selected.push_back(&individuals[index]);
+            forceEvaluations(selected);
+        }
+
+        void forceEvaluations(std::vector<Recipe>& individuals) const {
+            std::vector<Recipe*> all;
+            all.reserve(individuals.size());
+            for (Recipe& I: individuals) all.push_back(&I);
+            forceEvaluations(all);
+        }
+
+        void setSurrogate(const Surrogate& newSurrogate, const FitnessScore margin) {
+            surrogate = newSurrogate;
+            surrogateMargin = margin;
+        }
+
+        void setLowFidelityFitnessFunction(const FitnessFunction& newLowFidelityFitnessFunction, const double newPromotedProportion) {
+            lowFidelityFitnessFunction = newLowFidelityFitnessFunction;
+            promotedProportion = newPromotedProportion;
+        }
+
+        /**
+         * Successive halving: when there's a low fidelity fitness function, the individuals which would need an evaluation are first scored with it,
+         * and only the best promotedProportion of them are actually evaluated.
+         * The others keep their low fidelity score as an unreliable fitness, but never better than the worst of the promoted ones,
+         * since the two kinds of score aren't on the same scale.
+         */
+        void evaluateWithSuccessiveHalving(std::vector<Recipe>& individuals, const std::vector<size_t>& indexes) const {
+            std::vector<size_t> toEvaluate, candidates;
+            for (const size_t index: indexes) {
+                const Recipe& I = individuals[index];
+                if (I.isFitnessAssessed() || fitnessCache.count(I) > 0) toEvaluate.push_back(index); //it's free anyway
+                else candidates.push_back(index);
+            }
+            const size_t promotedAmount = (size_t)std::ceil(promotedProportion*candidates.size());
+            if (!lowFidelityFitnessFunction || promotedAmount >= candidates.size()) {
+                forceEvaluations(individuals, indexes);
+                return;
+            }
+
+            std::vector<FitnessScore> lowFidelityScores(candidates.size());
+            threadPool->forEachIndex(candidates.size(), [&](const size_t i) {
+                lowFidelityScores[i] = lowFidelityFitnessFunction(individuals[candidates[i]]);
+            });
+            std::vector<size_t> ranking(candidates.size());
+            std::iota(ranking.begin(), ranking.end(), 0);
+            std::stable_sort(ranking.begin(), ranking.end(), [&](const size_t A, const size_t B) { return lowFidelityScores[A] < lowFidelityScores[B]; });
+
+            for (size_t i=0;i<promotedAmount;i++) toEvaluate.push_back(candidates[ranking[i]]);
+            forceEvaluations(individuals, toEvaluate);
+
+            FitnessScore worstPromoted = 0;
+            for (size_t i=0;i<promotedAmount;i++) worstPromoted = std::max(worstPromoted, individuals[candidates[ranking[i]]].getFitness());
+            for (size_t i=promotedAmount;i<candidates.size();i++) {
+                Recipe& I = individuals[candidates[ranking[i]]];
+                const auto cached = fitnessCache.find(I); //it might have been promoted as another individual of the batch
+                if (cached != fitnessCache.end()) {
+                    cacheStatistics.hits++;
+                    setActualFitness(I, cached->second);
+                    continue;
+                }
+                cacheStatistics.lowFidelity++;
+                setFitnessScore(I, std::max(lowFidelityScores[ranking[i]], worstPromoted));
+                setReliability(I, screenedReliability);
+            }
+        }
+
+        /**
+         * Like forceEvaluations, but when there's a surrogate the individuals whose estimate is clearly worse than the best actual fitness so far
+         * get the estimate (as an unreliable fitness) instead of an evaluation, and the rest go through evaluateWithSuccessiveHalving
+         */
+        void evaluateOrScreen(std::vector<Recipe>& individuals, const std::vector<size_t>& indexes) const {
+            if (!surrogate || bestActualFitness == std::numeric_limits<FitnessScore>::max()) {
+                evaluateWithSuccessiveHalving(individuals, indexes);
+                return;
+            }
+
+            std::vector<size_t> toEvaluate;
+            for (const size_t index: indexes) {
+                Recipe& I = individuals[index];
+                if (I.isFitnessAssessed() || fitnessCache.count(I) > 0) {
+                    toEvaluate.push_back(index); //it's free anyway
+                    continue;
+                }
+                const FitnessScore estimate = surrogate(I);
+                if (estimate > bestActualFitness + surrogateMargin) {
+                    cacheStatistics.screened++;
+                    setFitnessScore(I, estimate);
+                    setReliability(I, screenedReliability);
+                }
+                else toEvaluate.push_back(index);
+            }
+            evaluateWithSuccessiveHalving(individuals, toEvaluate);
+        }
+
+        size_t getEvaluationThreads() const {
+            return threadPool->getThreadAmount();
+        }
+
+        const CacheStatistics& getCacheStatistics() const {
+            return cacheStatistics;
+        }
+
+        /**
+         * From now on the actual evaluations are logged. Unlike the order in which the threads call the fitness function,
+         * the order of the log only depends on the individuals, so it's what to use when the evaluations are collected (eg to train a surrogate)
+         */
+        void keepEvaluationLog() {
+            keepsEvaluationLog = true;
+        }
+
+        const std::vector<Evaluation>& getEvaluationLog() const {
+            return evaluationLog;
         }
 
 
@@ -11,6 +11,10 @@
 #include "../names.hpp"
 #include "../StatisticalFeatures/RunningAverage.hpp"
 #include "../EvolutionaryFileCompressor/EvoCompressorSettings/EvoComSettings.hpp"
+#include "../Random/RandomGenerator.hpp"
+#include <optional>
+#include <chrono>
+#include <limits>
 
 #define SHOW_ADAPTIVE_MUTATION 1
 
@@ -39,6 +43,41 @@ namespace GC {
 
             size_t minTransformAmount, maxTransformAmount;
 
+            size_t evaluationThreads; //how many threads evaluate the children of a generation (the result doesn't depend on it)
+            std::optional<RandomGenerator::Seed> seed; //when present, the evolver reseeds the generator of its thread with it
+
+            //stopping criteria, besides running out of generations
+            size_t stagnationLimit;     //stop after this many generations without improving the best evaluated fitness (0 means never)
+            double targetFitness;       //stop as soon as an evaluated fitness is this low (0 means never, since fitnesses are positive)
+            std::optional<std::chrono::milliseconds> timeBudget; //counted from the construction of the evolver, the best so far is returned when it runs out
+            size_t evaluationBudget;    //stop once the fitness function has been called this many times (0 means never)
+
+            //the island model, used by the IslandEvolver
+            size_t islandAmount;        //how many populations evolve side by side, each on its own thread (1 means a single ordinary evolver)
+            size_t migrationInterval;   //the islands send their best individuals to the next one every this many generations
+            size_t migrantAmount;       //how many individuals each island sends
+
+            //when the population starts from a hint (the elite of a similar segment), the evolution stops after warmStartCheckGeneration generations
+            //if the best hint is within warmStartTolerance of the best evaluated fitness, since the hint was already good enough (0 generations means never)
+            size_t warmStartCheckGeneration;
+            double warmStartTolerance;
+
+            double surrogateMargin;     //when there's a surrogate (see setSurrogate), a child is only evaluated if its estimate is within this of the best fitness
+
+            //the beam search, used by the BeamSearcher instead of the evolution for the segments of at most beamSearchMaxSegmentSize bytes (0 means never)
+            size_t beamSearchMaxSegmentSize;
+            size_t beamWidth;           //how many transform chains are extended at each level
+            size_t beamDepth;           //how many levels, that is the length of the longest chain
+
+            //multi fidelity evaluation: the children which need an evaluation are first scored on the first lowFidelitySampleSize bytes of the sample
+            //(0 means never), and only the best promotedProportion of them are evaluated on the whole sample.
+            //Then the elite is compared again on the first championSampleSize bytes of the segment (0 means never) to pick the recipe
+            size_t lowFidelitySampleSize;
+            double promotedProportion;
+            size_t championSampleSize;
+
+            bool keepsEvaluationLog; //see Evaluator::keepEvaluationLog
+
             EvolutionSettings() :
                 populationSize(40),
                 generationCount(100),
@@ -49,7 +88,24 @@ namespace GC {
                 eliteSize(2),
                 mutationThreshold(0.75),
                 minTransformAmount(0),
-                maxTransformAmount(6){}
+                maxTransformAmount(6),
+                evaluationThreads(1),
+                stagnationLimit(0),
+                targetFitness(0),
+                evaluationBudget(0),
+                islandAmount(1),
+                migrationInterval(5),
+                migrantAmount(2),
+                warmStartCheckGeneration(3),
+                warmStartTolerance(0.005),
+                surrogateMargin(0.5),
+                beamSearchMaxSegmentSize(0),
+                beamWidth(2),
+                beamDepth(3),
+                lowFidelitySampleSize(0),
+                promotedProportion(0.25),
+                championSampleSize(0),
+                keepsEvaluationLog(false){}
 
 
             explicit EvolutionSettings(const EvoComSettings& settings) :
@@ -57,18 +113,41 @@ namespace GC {
                 generationCount(settings.generations),
                 chanceOfMutation(settings.mutationRate),
                 chanceOfCompressionCrossover(settings.compressionCrossoverRate),
-                tournamentSelectionProportion(settings.population / settings.tournamentSelectionSize),
+                tournamentSelectionProportion((double)settings.tournamentSelectionSize / settings.population),
                 usesSimulatedAnnealing(settings.usesAnnealing),
                 eliteSize(settings.eliteSize),
                 mutationThreshold(settings.excessiveMutationThreshold),
                 minTransformAmount(settings.minTransformAmount),
-                maxTransformAmount(settings.maxTransformAmount){
+                maxTransformAmount(settings.maxTransformAmount),
+                evaluationThreads(settings.evaluationThreads),
+                seed(settings.seed),
+                stagnationLimit(settings.stagnationLimit),
+                targetFitness(settings.targetFitness),
+                evaluationBudget(0), //the budgets for a file are shared between its segments by the EffortScheduler
+                islandAmount(settings.islandAmount),
+                migrationInterval(settings.migrationInterval),
+                migrantAmount(settings.migrantAmount),
+                warmStartCheckGeneration(settings.warmStartCheckGeneration),
+                warmStartTolerance(settings.warmStartTolerance),
+                surrogateMargin(settings.surrogateMargin),
+                beamSearchMaxSegmentSize(settings.getBeamSearchMaxSegmentSize()),
+                beamWidth(settings.beamWidth),
+                beamDepth(settings.beamDepth),
+                lowFidelitySampleSize(settings.lowFidelitySampleSize),
+                promotedProportion(settings.promotedProportion),
+                championSampleSize(settings.championSampleSize),
+                keepsEvaluationLog(false){
+                if (settings.segmentTimeBudgetInMilliseconds > 0)
+                    timeBudget = std::chrono::milliseconds(settings.segmentTimeBudgetInMilliseconds);
 
             }
         };
 
         using Fitness = Recipe::FitnessScore;
         using FitnessFunction = Evaluator::FitnessFunction;
+        using Clock = std::chrono::steady_clock;
+
+        enum class StopReason {Completed, ExtremeMutation, Stagnation, TargetReached, Deadline, BudgetExhausted, HintConfirmed};
 
     private:
         Breeder breeder;
@@ -86,6 +165,21 @@ namespace GC {
         size_t eliteSize;
         const double excessiveMutationThreshold;
 
+        const size_t stagnationLimit;
+        const Fitness targetFitness;
+        const std::optional<Clock::time_point> deadline;
+        const size_t evaluationBudget;
+        const size_t warmStartCheckGeneration;
+        const double warmStartTolerance;
+        const double surrogateMargin;
+        const double promotedProportion;
+        std::optional<Fitness> bestHintFitness; //only when the population started from a hint
+
+        Recipe bestEvaluatedIndividual; //the best individual with an actual fitness seen so far
+        Fitness bestEvaluatedFitness = std::numeric_limits<Fitness>::max();
+        size_t generationsWithoutImprovement = 0;
+        StopReason stopReason = StopReason::Completed;
+
 
     private: //methods
         void initialiseRandomPopulation() {
@@ -99,24 +193,31 @@ namespace GC {
             repeat(populationSize, addRandomIndividual);
 
             forcePopulationFitnessAssessment();
+            registerProgress();
         }
 
+        /**
+         * The hint takes up to half of the population, and the rest is random so that there's still some diversity.
+         * The fitnesses of the hint are discarded, since they were assessed on another block.
+         */
         void initialiseHintedPopulation(const std::vector<Recipe>& hint) {
-            for (auto hintItem: hint) {
-            }
-
-            RandomElement<Recipe> randomHint(hint);
             Breeder::RandomIndividual randomIndividualMaker(breeder);
-            RandomChance chooseIfRandom(0.5);//(1.0/(hint.size()+1));
             population = std::vector<Recipe>();
 
-            auto makeIndividual = [&]() -> Recipe {
-                if (chooseIfRandom.choose()) return randomIndividualMaker.makeIndividual();
-                else return randomHint.choose();
-            };
+            const size_t hintAmount = std::min(hint.size(), std::max<size_t>(populationSize/2, 1));
+            for (size_t i=0;i<hintAmount;i++) {
+                Recipe hintItem = hint[i];
+                hintItem.getPseudoFitness() = Recipe::Fitness();
+                population.push_back(hintItem);
+            }
+            repeat(populationSize - hintAmount, [&](){population.push_back(randomIndividualMaker.makeIndividual());});
 
-            repeat(populationSize, [&](){population.push_back(makeIndividual());});
             forcePopulationFitnessAssessment();
+            registerProgress();
+            if (hintAmount > 0) {
+                auto getFitness = [&](const Recipe& individual) { return individual.getFitness(); };
+                bestHintFitness = getMinimumBy(std::vector<Recipe>(population.begin(), population.begin()+hintAmount), getFitness).getFitness();
+            }
             //LOG("at the end, the population is"); LOGPopulation();
         }
 
@@ -142,50 +243,126 @@ namespace GC {
             breeder.setMutationRate(initialMutationRate);
         }
 
+        static std::optional<Clock::time_point> getDeadline(const EvolutionSettings& settings) {
+            if (!settings.timeBudget) return {};
+            return Clock::now() + *settings.timeBudget;
+        }
+
+        /**
+         * Keeps track of the best actually evaluated individual, since the inherited fitnesses can be optimistic
+         * @return whether it improved
+         */
+        bool updateBestEvaluated() {
+            bool hasImproved = false;
+            for (const Recipe& individual: population) {
+                if (individual.isFitnessAssessed() && individual.getFitness() < bestEvaluatedFitness) {
+                    bestEvaluatedFitness = individual.getFitness();
+                    bestEvaluatedIndividual = individual;
+                    hasImproved = true;
+                }
+            }
+            return hasImproved;
+        }
+
+        void registerProgress() {
+            generationsWithoutImprovement = updateBestEvaluated() ? 0 : generationsWithoutImprovement+1;
+        }
+
+        /**
+         * Checked once, after warmStartCheckGeneration generations
+         */
+        bool isHintConfirmed() const {
+            return bestHintFitness && warmStartCheckGeneration > 0 && generationCount == warmStartCheckGeneration
+                   && *bestHintFitness <= bestEvaluatedFitness + warmStartTolerance;
+        }
+
+        /**
+         * Checked before each generation, sets stopReason when it returns true
+         */
+        bool shouldStop() {
+            if (mutationIsExtreme()) stopReason = StopReason::ExtremeMutation;
+            else if (stagnationLimit > 0 && generationsWithoutImprovement >= stagnationLimit) stopReason = StopReason::Stagnation;
+            else if (bestEvaluatedFitness <= targetFitness) stopReason = StopReason::TargetReached;
+            else if (deadline && Clock::now() >= *deadline) stopReason = StopReason::Deadline;
+            else if (evaluationBudget > 0 && evaluator.getCacheStatistics().misses >= evaluationBudget) stopReason = StopReason::BudgetExhausted;
+            else if (isHintConfirmed()) stopReason = StopReason::HintConfirmed;
+            else return false;
+            return true;
+        }
+
 
     public:
         Evolver(const EvolutionSettings settings, const FitnessFunction fitnessFunction) :
             populationSize(settings.populationSize),
             amountOfGenerations(settings.generationCount),
-            evaluator(fitnessFunction),
+            evaluator(fitnessFunction, settings.evaluationThreads),
             breeder(settings.chanceOfMutation, settings.chanceOfCompressionCrossover, settings.minTransformAmount, settings.maxTransformAmount),
             selector(Selector::SelectionKind(Selector::TournamentSelection(settings.tournamentSelectionProportion))),
             initialMutationRate(settings.chanceOfMutation),
             usesSimulatedAnnealing(settings.usesSimulatedAnnealing),
             eliteSize(settings.eliteSize),
-            excessiveMutationThreshold(settings.mutationThreshold)
+            excessiveMutationThreshold(settings.mutationThreshold),
+            stagnationLimit(settings.stagnationLimit),
+            targetFitness(settings.targetFitness),
+            deadline(getDeadline(settings)),
+            evaluationBudget(settings.evaluationBudget),
+            warmStartCheckGeneration(settings.warmStartCheckGeneration),
+            warmStartTolerance(settings.warmStartTolerance),
+            surrogateMargin(settings.surrogateMargin),
+            promotedProportion(settings.promotedProportion)
             {
+                if (settings.seed) RandomGenerator::seedThisThread(*settings.seed);
+                if (settings.keepsEvaluationLog) evaluator.keepEvaluationLog();
                 initialiseRandomPopulation();
             }
 
 
-        Evolver(const EvolutionSettings settings, const FitnessFunction fitnessFunction, std::vector<Recipe>& hint) :
+        Evolver(const EvolutionSettings settings, const FitnessFunction fitnessFunction, const std::vector<Recipe>& hint) :
                 populationSize(settings.populationSize),
                 amountOfGenerations(settings.generationCount),
-                evaluator(fitnessFunction),
+                evaluator(fitnessFunction, settings.evaluationThreads),
                 breeder(settings.chanceOfMutation, settings.chanceOfCompressionCrossover, settings.minTransformAmount, settings.maxTransformAmount),
                 selector(Selector::SelectionKind(Selector::TournamentSelection(settings.tournamentSelectionProportion))),
                 initialMutationRate(settings.chanceOfMutation),
                 usesSimulatedAnnealing(settings.usesSimulatedAnnealing),
-                excessiveMutationThreshold(settings.mutationThreshold)
+                eliteSize(settings.eliteSize),
+                excessiveMutationThreshold(settings.mutationThreshold),
+                stagnationLimit(settings.stagnationLimit),
+                targetFitness(settings.targetFitness),
+                deadline(getDeadline(settings)),
+                evaluationBudget(settings.evaluationBudget),
+                warmStartCheckGeneration(settings.warmStartCheckGeneration),
+                warmStartTolerance(settings.warmStartTolerance),
+                surrogateMargin(settings.surrogateMargin),
+                promotedProportion(settings.promotedProportion)
         {
-            initialiseHintedPopulation(hint);
+            if (settings.seed) RandomGenerator::seedThisThread(*settings.seed);
+            if (settings.keepsEvaluationLog) evaluator.keepEvaluationLog();
+            if (hint.empty()) initialiseRandomPopulation();
+            else initialiseHintedPopulation(hint);
         }
 
+        /**
+         * The children are bred one after the other (that's where all the randomness is),
+         * and then the ones which need an actual evaluation are evaluated together, possibly in parallel
+         */
         void evolveRepetitiveSingleGeneration() {
             //LOG("The current population is"); for (auto individual: population) LOG(individual.to_string());
             Population children = selector.selectElite(eliteSize, population);
+            std::vector<size_t> childrenToEvaluate;
 
             selector.preparePool(population);
             auto addNewIndividual = [&]() {
                 //LOG("Adding a new member to the population");
-                Recipe parentA = selector.select();
-                Recipe parentB = selector.select();
+                const Recipe& parentA = selector.select();
+                const Recipe& parentB = selector.select();
                 Recipe newChild = breeder.mutate(breeder.crossover(parentA, parentB));
-                evaluator.decideFitness(newChild, parentA, parentB);
+                if (evaluator.inheritFitness(newChild, parentA, parentB))
+                    childrenToEvaluate.push_back(children.size());
                 children.emplace_back(newChild);
             };
             repeat(populationSize - eliteSize, addNewIndividual);
+            evaluator.evaluateOrScreen(children, childrenToEvaluate);
             population = children;
 
             runningAverageFitness.registerNewValue(getBestOfPopulation(false).getFitness());
@@ -198,8 +375,8 @@ namespace GC {
             selector.preparePool(population);
 
             auto generateChild = [&]()->Recipe {
-                const Recipe parentA = selector.select();
-                const Recipe parentB = selector.select();
+                const Recipe& parentA = selector.select();
+                const Recipe& parentB = selector.select();
                 Recipe newChild = breeder.mutate(breeder.crossover(parentA, parentB));
                 evaluator.decideFitness(newChild, parentA, parentB);
                 return newChild;
@@ -255,19 +432,25 @@ namespace GC {
         }
 
 
+        /**
+         * Runs one more generation, unless the evolution is over
+         * @return false if it's over, and then getStopReason says why
+         */
+        bool evolveNextGeneration() {
+            if (generationCount >= amountOfGenerations || shouldStop())
+                return false;
+            evolveGenerationOnce();
+            registerProgress();
+            adaptParameters();
+            return true;
+        }
+
         void evolveForGenerations() {
-            for (size_t i=0;i<amountOfGenerations;i++) {
-                if (mutationIsExtreme()) {
-                    return;
-                }
-                evolveGenerationOnce();
-                adaptParameters();
-            }
+            while (evolveNextGeneration());
         }
 
         void forcePopulationFitnessAssessment() {
-            std::for_each(population.begin(), population.end(),
-                          [&](Recipe& i){evaluator.forceEvaluation(i);});
+            evaluator.forceEvaluations(population);
         }
 
         void LOGPopulation() {
@@ -286,15 +469,75 @@ namespace GC {
         }
 
 
+        /**
+         * The result of the evolution, once evolveNextGeneration returned false
+         */
+        Recipe finishEvolution() {
+            if (stopReason == StopReason::Deadline) return bestEvaluatedIndividual; //no time for more evaluations
+            return getBestOfPopulation(true);
+        }
+
         Recipe evolveBest() {
             evolveForGenerations();
-            return getBestOfPopulation(true);
+            return finishEvolution();
+        }
+
+        /**
+         * From now on, the children which the surrogate considers clearly worse than the best so far aren't evaluated
+         * (the initial population is always evaluated)
+         */
+        void setSurrogate(const Evaluator::Surrogate& surrogate) {
+            evaluator.setSurrogate(surrogate, surrogateMargin);
+        }
+
+        /**
+         * From now on, the children which need an evaluation are first scored with the low fidelity fitness function,
+         * and only the best promotedProportion of them are actually evaluated (see Evaluator::evaluateWithSuccessiveHalving)
+         */
+        void setLowFidelityFitnessFunction(const FitnessFunction& lowFidelityFitnessFunction) {
+            evaluator.setLowFidelityFitnessFunction(lowFidelityFitnessFunction, promotedProportion);
+        }
+
+        Population getElite(const size_t amount) {
+            return selector.selectElite(std::min(amount, population.size()), population);
+        }
+
+        /**
+         * Replaces the worst individuals of the population with the immigrants (from another island)
+         */
+        void receiveImmigrants(const Population& immigrants) {
+            std::vector<size_t> indexes(population.size());
+            std::iota(indexes.begin(), indexes.end(), 0);
+            const size_t amount = std::min(immigrants.size(), population.size());
+            auto isIndividualWorse = [&](const size_t A, const size_t B) {
+                return population[A].getFitness() > population[B].getFitness();
+            };
+            std::partial_sort(indexes.begin(), indexes.begin()+amount, indexes.end(), isIndividualWorse);
+            for (size_t i=0;i<amount;i++)
+                population[indexes[i]] = immigrants[i];
+            updateBestEvaluated();
+        }
+
+        StopReason getStopReason() const {
+            return stopReason;
+        }
+
+        size_t getGenerationsRun() const {
+            return generationCount;
         }
 
         void reset() {
             initialiseRandomPopulation();
         }
 
+        const Evaluator::CacheStatistics& getFitnessCacheStatistics() const {
+            return evaluator.getCacheStatistics();
+        }
+
+        const std::vector<Evaluator::Evaluation>& getEvaluationLog() const {
+            return evaluator.getEvaluationLog();
+        }
+
         Recipe evolveBestAndLogProgress(Logger &logger) {
             size_t generationCounter = 0;
 
@@ -309,6 +552,7 @@ namespace GC {
                 logger.addVar("Mutation", breeder.getMutationRate());
                 logger.addVar("runningAverage", runningAverageFitness.getAverage());
                 logger.addVar("deviation", runningAverageFitness.getDeviation());
+                logger.addVar("FitnessCacheHitRate", getFitnessCacheStatistics().getHitRate());
                 logger.beginList("Population");
                 std::for_each(population.begin(), population.end(), [&](const Recipe& i){
                     logger.addListItem(i.to_string());
@@ -319,8 +563,9 @@ namespace GC {
 
             auto evolveForGenerationsAndLog = [&]() { //mimics evolveForGenerations
                 for (size_t i=0;i<amountOfGenerations;i++) {
-                    if (mutationIsExtreme()) return;
+                    if (shouldStop()) return;
                     evolveGenerationOnce();
+                    registerProgress();
                     logGenerationData();
                     adaptParameters();
                 }
@@ -328,7 +573,7 @@ namespace GC {
 
             evolveForGenerationsAndLog();
 
-            return getBestOfPopulation(true);
+            return finishEvolution();
         }
     };
 
@@ -0,0 +1,114 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "IslandEvolver.hpp"
+#include <thread>
+#include <numeric>
+
+namespace GC {
+
+    IslandEvolver::IslandEvolver(const Evolver::EvolutionSettings& settings, const FitnessFunction& fitnessFunction, const std::vector<Recipe>& hint) :
+        settings(settings),
+        fitnessFunction(fitnessFunction),
+        hint(hint),
+        islandAmount(std::max<size_t>(settings.islandAmount, 1)),
+        migrantAmount(std::min(settings.migrantAmount, maxMigrants)),
+        hasFinished(new std::atomic<bool>[islandAmount]) {
+        for (size_t i=0;i<islandAmount;i++) {
+            mailboxes.push_back(std::make_unique<MigrationMailbox>());
+            hasFinished[i] = false;
+        }
+    }
+
+    Evolver::EvolutionSettings IslandEvolver::getIslandSettings(const size_t islandIndex) const {
+        Evolver::EvolutionSettings islandSettings = settings;
+        islandSettings.islandAmount = 1;
+        islandSettings.evaluationThreads = std::max<size_t>(settings.evaluationThreads / islandAmount, 1);
+        if (settings.seed && islandAmount > 1) islandSettings.seed = RandomGenerator::deriveSeed(*settings.seed, islandIndex);
+        if (settings.evaluationBudget > 0) islandSettings.evaluationBudget = std::max<size_t>(settings.evaluationBudget / islandAmount, 1);
+        return islandSettings;
+    }
+
+    void IslandEvolver::send(const size_t islandIndex, const Migration& migration) {
+        while (!getOutbox(islandIndex).tryPost(migration)) {
+            if (hasFinished[getNextIsland(islandIndex)]) return;
+            std::this_thread::yield();
+        }
+    }
+
+    void IslandEvolver::runIsland(const size_t islandIndex, IslandOutcome& outcome) {
+        Evolver evolver(getIslandSettings(islandIndex), fitnessFunction, hint); //constructed here, since it seeds the generator of its thread
+        if (surrogate) evolver.setSurrogate(surrogate);
+        if (lowFidelityFitnessFunction) evolver.setLowFidelityFitnessFunction(lowFidelityFitnessFunction);
+        bool isPreviousIslandRunning = islandAmount > 1;
+
+        auto migrate = [&]() {
+            Migration outgoing;
+            const Evolver::Population elite = evolver.getElite(migrantAmount);
+            std::copy(elite.begin(), elite.end(), outgoing.migrants.begin());
+            outgoing.amount = elite.size();
+            outgoing.generation = evolver.getGenerationsRun();
+            send(islandIndex, outgoing);
+
+            while (isPreviousIslandRunning) {
+                const std::optional<Migration> incoming = getInbox(islandIndex).tryTake();
+                if (!incoming) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (incoming->isFinal) isPreviousIslandRunning = false;
+                else {
+                    ASSERT_EQUALS(incoming->generation, outgoing.generation);
+                    evolver.receiveImmigrants(Evolver::Population(incoming->migrants.begin(), incoming->migrants.begin()+incoming->amount));
+                }
+                return;
+            }
+        };
+
+        while (evolver.evolveNextGeneration()) {
+            if (islandAmount > 1 && evolver.getGenerationsRun() % settings.migrationInterval == 0)
+                migrate();
+        }
+
+        if (islandAmount > 1) {
+            Migration lastMigration;
+            lastMigration.isFinal = true;
+            send(islandIndex, lastMigration);
+        }
+        hasFinished[islandIndex] = true;
+
+        outcome.result = evolver.finishEvolution();
+        outcome.elite = evolver.getElite(settings.eliteSize);
+        outcome.statistics = evolver.getFitnessCacheStatistics();
+        outcome.evaluationLog = evolver.getEvaluationLog();
+    }
+
+    Recipe IslandEvolver::evolveBest() {
+        std::vector<IslandOutcome> outcomes(islandAmount);
+
+        if (islandAmount == 1) runIsland(0, outcomes[0]);
+        else {
+            //every island needs its own thread, since they wait for each other
+            std::vector<std::thread> threads;
+            for (size_t i=0;i<islandAmount;i++)
+                threads.emplace_back([&, i](){runIsland(i, outcomes[i]);});
+            for (std::thread& thread: threads) thread.join();
+        }
+
+        cacheStatistics = Evaluator::CacheStatistics();
+        evaluationLog.clear();
+        for (const IslandOutcome& outcome: outcomes) {
+            cacheStatistics += outcome.statistics;
+            evaluationLog.insert(evaluationLog.end(), outcome.evaluationLog.begin(), outcome.evaluationLog.end());
+        }
+
+        auto getFitness = [&](const size_t islandIndex) { return outcomes[islandIndex].result.getFitness(); };
+        std::vector<size_t> islandIndexes(islandAmount);
+        std::iota(islandIndexes.begin(), islandIndexes.end(), 0);
+        const size_t bestIsland = getMinimumBy(islandIndexes, getFitness);
+        elite = outcomes[bestIsland].elite;
+        return outcomes[bestIsland].result;
+    }
+
+} // GC
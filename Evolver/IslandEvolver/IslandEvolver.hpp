@@ -0,0 +1,108 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_ISLANDEVOLVER_HPP
+#define EVOCOM_ISLANDEVOLVER_HPP
+
+#include "../Evolver.hpp"
+#include "../../Utilities/Mailbox/Mailbox.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+
+namespace GC {
+
+    /**
+     * The island model: several Evolvers (the islands) evolve side by side, each on its own thread,
+     * and every migrationInterval generations each island sends its best individuals to the next one (in a ring),
+     * where they replace the worst individuals. This gives a segment parallelism beyond the evaluation of a generation,
+     * and the islands explore different areas of the search space.
+     *
+     * The individuals travel through lock free Mailboxes. An island waits for the migration of the same generation from the previous island,
+     * so when there's a seed the result doesn't depend on the scheduling of the threads (an island is at most a few migrations ahead of another).
+     * When an island stops, it sends a final message so that the next one stops waiting for it.
+     */
+    class IslandEvolver {
+    public:
+        using FitnessFunction = Evolver::FitnessFunction;
+        static constexpr size_t maxMigrants = 4;
+
+        struct Migration {
+            std::array<Recipe, maxMigrants> migrants;
+            size_t amount = 0;
+            size_t generation = 0;
+            bool isFinal = false; //the sender has stopped, there won't be more migrations
+        };
+
+        using MigrationMailbox = Mailbox<Migration, 4>;
+
+    private:
+        const Evolver::EvolutionSettings settings;
+        const FitnessFunction fitnessFunction;
+        const std::vector<Recipe> hint; //every island starts from it
+        Evaluator::Surrogate surrogate;  //given to every island, when present
+        FitnessFunction lowFidelityFitnessFunction; //same
+        const size_t islandAmount;
+        const size_t migrantAmount;
+
+        std::vector<std::unique_ptr<MigrationMailbox>> mailboxes; //mailbox i receives what island i-1 sends
+        std::unique_ptr<std::atomic<bool>[]> hasFinished;         //so that a sender doesn't wait for a full mailbox that nobody reads anymore
+
+        Evaluator::CacheStatistics cacheStatistics;
+        Evolver::Population elite; //of the island with the best result
+        std::vector<Evaluator::Evaluation> evaluationLog; //the logs of the islands, one after the other
+
+        Evolver::EvolutionSettings getIslandSettings(const size_t islandIndex) const;
+        MigrationMailbox& getInbox(const size_t islandIndex) { return *mailboxes[islandIndex]; }
+        size_t getNextIsland(const size_t islandIndex) const { return (islandIndex+1) % islandAmount; }
+        MigrationMailbox& getOutbox(const size_t islandIndex) { return *mailboxes[getNextIsland(islandIndex)]; }
+
+        void send(const size_t islandIndex, const Migration& migration);
+        struct IslandOutcome {
+            Recipe result;
+            Evolver::Population elite;
+            Evaluator::CacheStatistics statistics;
+            std::vector<Evaluator::Evaluation> evaluationLog;
+        };
+
+        void runIsland(const size_t islandIndex, IslandOutcome& outcome);
+
+    public:
+        IslandEvolver(const Evolver::EvolutionSettings& settings, const FitnessFunction& fitnessFunction, const std::vector<Recipe>& hint = {});
+
+        /**
+         * Runs all the islands until they stop
+         * @return the best of their results
+         */
+        Recipe evolveBest();
+
+        /**
+         * @return the statistics of all the islands together
+         */
+        const Evaluator::CacheStatistics& getFitnessCacheStatistics() const { return cacheStatistics; }
+
+        /**
+         * @return the elite of the island which found the best result, at most settings.eliteSize individuals
+         */
+        Evolver::Population getElite(const size_t amount) const {
+            return {elite.begin(), elite.begin()+std::min(amount, elite.size())};
+        }
+
+        /**
+         * @return the evaluation logs of the islands, in the order of the islands (empty unless settings.keepsEvaluationLog)
+         */
+        const std::vector<Evaluator::Evaluation>& getEvaluationLog() const { return evaluationLog; }
+
+        size_t getIslandAmount() const { return islandAmount; }
+
+        void setSurrogate(const Evaluator::Surrogate& newSurrogate) { surrogate = newSurrogate; }
+
+        void setLowFidelityFitnessFunction(const FitnessFunction& newLowFidelityFitnessFunction) {
+            lowFidelityFitnessFunction = newLowFidelityFitnessFunction;
+        }
+    };
+
+} // GC
+
+#endif //EVOCOM_ISLANDEVOLVER_HPP
@@ -12,7 +12,8 @@ namespace GC {
         C_HuffmanCompression,
         C_RunLengthCompression,
         C_SmallValueCompression,
-        C_LZWCompression
+        C_LZWCompression,
+        C_AmountOfCCodes //not a compression, it's always last so that it counts the codes above
     };
 
     const std::vector<std::string> CCodesAsStrings = {
@@ -0,0 +1,193 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_PACKEDTLIST_HPP
+#define EVOCOM_PACKEDTLIST_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <initializer_list>
+#include <vector>
+#include "../../Utilities/utilities.hpp"
+#include "TCodes.hpp"
+
+namespace GC {
+
+    /**
+     * A list of transform codes packed in two 64 bit words: the length in the lowest 4 bits of the first word, followed by 6 bits per code,
+     * continuing in the second word once the first is full.
+     * It's trivially copyable, so copying, comparing and hashing a recipe never touches the heap,
+     * which matters since the evolver copies recipes around all the time (selection, breeding, the fitness cache).
+     *
+     * It behaves like a (small) vector, but the elements are values and not references, so they're changed through set.
+     */
+    class PackedTList {
+    public:
+        using Word = uint64_t;
+        using value_type = TCode;
+        using size_type = size_t;
+
+        static constexpr size_t bitsForLength = 4;
+        static constexpr size_t bitsPerCode = 6;
+        static constexpr size_t codesInFirstWord = (64 - bitsForLength) / bitsPerCode;
+        static constexpr size_t capacity = 14; //the file format stores the amount of transforms in 4 bits, 15 being the marker of a versioned file
+
+        static_assert(T_AmountOfTCodes <= (1 << bitsPerCode), "every TCode needs to fit in bitsPerCode");
+        static_assert(capacity < (1 << bitsForLength), "the capacity needs to fit in bitsForLength");
+        static_assert(capacity - codesInFirstWord <= 64 / bitsPerCode, "the remaining codes need to fit in the second word");
+
+    private:
+        static constexpr Word lengthMask = (Word(1) << bitsForLength) - 1;
+        static constexpr Word codeMask = (Word(1) << bitsPerCode) - 1;
+
+        Word first = 0;
+        Word second = 0;
+
+        static constexpr size_t shiftFor(const size_t index) {
+            return index < codesInFirstWord ? bitsForLength + index*bitsPerCode : (index-codesInFirstWord)*bitsPerCode;
+        }
+        Word& wordFor(const size_t index) { return index < codesInFirstWord ? first : second; }
+        const Word& wordFor(const size_t index) const { return index < codesInFirstWord ? first : second; }
+
+        void setSize(const size_t newSize) { first = (first & ~lengthMask) | newSize; }
+
+        //also used on the unused slots, to keep them at 0 so that the equality and the hash only depend on the codes
+        void setSlot(const size_t index, const Word bits) {
+            Word& word = wordFor(index);
+            word = (word & ~(codeMask << shiftFor(index))) | (bits << shiftFor(index));
+        }
+
+    public:
+        class const_iterator {
+            const PackedTList* list = nullptr;
+            std::ptrdiff_t index = 0;
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = TCode;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = TCode;
+
+            const_iterator() = default;
+            const_iterator(const PackedTList* list, const std::ptrdiff_t index) : list(list), index(index) {}
+
+            TCode operator*() const { return (*list)[index]; }
+            TCode operator[](const difference_type offset) const { return (*list)[index+offset]; }
+
+            const_iterator& operator++() { index++; return *this; }
+            const_iterator& operator--() { index--; return *this; }
+            const_iterator operator++(int) { const_iterator old = *this; index++; return old; }
+            const_iterator operator--(int) { const_iterator old = *this; index--; return old; }
+            const_iterator& operator+=(const difference_type offset) { index += offset; return *this; }
+            const_iterator& operator-=(const difference_type offset) { index -= offset; return *this; }
+            const_iterator operator+(const difference_type offset) const { return {list, index+offset}; }
+            const_iterator operator-(const difference_type offset) const { return {list, index-offset}; }
+            friend const_iterator operator+(const difference_type offset, const const_iterator& it) { return it+offset; }
+            difference_type operator-(const const_iterator& other) const { return index - other.index; }
+
+            bool operator==(const const_iterator& other) const { return index == other.index; }
+            bool operator!=(const const_iterator& other) const { return index != other.index; }
+            bool operator<(const const_iterator& other) const { return index < other.index; }
+            bool operator>(const const_iterator& other) const { return index > other.index; }
+            bool operator<=(const const_iterator& other) const { return index <= other.index; }
+            bool operator>=(const const_iterator& other) const { return index >= other.index; }
+
+            size_t getIndex() const { return index; }
+        };
+        using iterator = const_iterator;
+
+        PackedTList() = default;
+
+        /**
+         * A list of amount identity transforms (like the vector constructor, which would value initialise them)
+         */
+        explicit PackedTList(const size_t amount) {
+            ASSERT_LESS_EQ(amount, capacity);
+            setSize(amount);
+        }
+
+        PackedTList(std::initializer_list<TCode> tCodes) {
+            for (const TCode tCode : tCodes) push_back(tCode);
+        }
+
+        template <class Iterator>
+        PackedTList(Iterator begin, const Iterator end) {
+            for (;begin!=end;++begin) push_back(*begin);
+        }
+
+        size_t size() const { return first & lengthMask; }
+        bool empty() const { return size() == 0; }
+
+        TCode operator[](const size_t index) const {
+            return static_cast<TCode>((wordFor(index) >> shiftFor(index)) & codeMask);
+        }
+
+        TCode front() const { return (*this)[0]; }
+        TCode back() const { return (*this)[size()-1]; }
+
+        void set(const size_t index, const TCode tCode) {
+            ASSERT(index < size());
+            setSlot(index, tCode);
+        }
+
+        void push_back(const TCode tCode) {
+            const size_t oldSize = size();
+            ASSERT(oldSize < capacity);
+            setSize(oldSize+1);
+            set(oldSize, tCode);
+        }
+
+        void pop_back() {
+            ASSERT(!empty());
+            const size_t newSize = size()-1;
+            setSlot(newSize, 0);
+            setSize(newSize);
+        }
+
+        void clear() { first = 0; second = 0; }
+
+        void insert(const const_iterator position, const TCode tCode) {
+            const size_t index = position.getIndex();
+            const size_t oldSize = size();
+            ASSERT(oldSize < capacity && index <= oldSize);
+            setSize(oldSize+1);
+            for (size_t i=oldSize;i>index;i--) setSlot(i, (*this)[i-1]); //moved one by one, since they might cross the boundary between the words
+            set(index, tCode);
+        }
+
+        void erase(const const_iterator position) {
+            const size_t index = position.getIndex();
+            const size_t oldSize = size();
+            ASSERT(index < oldSize);
+            for (size_t i=index;i+1<oldSize;i++) setSlot(i, (*this)[i+1]);
+            pop_back();
+        }
+
+        const_iterator begin() const { return {this, 0}; }
+        const_iterator end() const { return {this, (std::ptrdiff_t)size()}; }
+        std::reverse_iterator<const_iterator> rbegin() const { return std::reverse_iterator<const_iterator>(end()); }
+        std::reverse_iterator<const_iterator> rend() const { return std::reverse_iterator<const_iterator>(begin()); }
+
+        /**
+         * Writes the codes to a plain array, for the code which needs them contiguous (eg the TilePipeline)
+         * @return the amount of codes written
+         */
+        size_t unpackInto(TCode* destination) const {
+            for (size_t i=0;i<size();i++) destination[i] = (*this)[i];
+            return size();
+        }
+
+        std::vector<TCode> toVector() const { return {begin(), end()}; }
+
+        Word getFirstWord() const { return first; }
+        Word getSecondWord() const { return second; }
+
+        bool operator==(const PackedTList& other) const { return first == other.first && second == other.second; }
+        bool operator!=(const PackedTList& other) const { return !(*this == other); }
+    };
+
+} // GC
+
+#endif //EVOCOM_PACKEDTLIST_HPP
@@ -13,6 +13,7 @@
 #include "../../Utilities/utilities.hpp"
 #include "TCodes.hpp"
 #include "CCodes.hpp"
+#include "PackedTList.hpp"
 #include "../../Random/RandomElement.hpp"
 #include <optional>
 #include "../PseudoFitness/PseudoFitness.hpp"
@@ -28,11 +29,10 @@ namespace GC {
         using Fitness = PseudoFitness;
         using FitnessScore = PseudoFitness::FitnessScore;
 
-        static constexpr size_t maxTransformAmount_STATIC = 6;
+        using TList = PackedTList; //a single word, so that recipes are trivially copyable
 
+        static constexpr size_t maxTransformAmount_STATIC = TList::capacity;
 
-
-        using TList = std::vector<TCode>;
     public: //attributes, these are all public for convenience
         TList tList;
         CCode cCode;
@@ -94,12 +94,7 @@ namespace GC {
 
         void setTItem(const TCode tCode, const size_t index) {
             ASSERT(index < tList.size());
-            tList[index] = tCode;
-        }
-
-        TCode& getTCode(const size_t index) {
-            ASSERT(index < tList.size());
-            return tList[index];
+            tList.set(index, tCode);
         }
 
         CCode& getCCode() {
@@ -116,7 +111,7 @@ namespace GC {
         }
 
         void copyTCodeFrom(const size_t index, const Recipe& A) {
-            getTCode(index) = A.readTCode(index);
+            setTItem(A.readTCode(index), index);
         }
 
         void copyCCodeFrom(const Recipe& A) {
@@ -154,6 +149,8 @@ namespace GC {
         return (lhs.cCode == rhs.cCode) && (lhs.tList == rhs.tList);
     }
 
+    static_assert(std::is_trivially_copyable_v<Recipe>, "recipes are copied around by the evolver, they shouldn't allocate");
+
 
 
 
@@ -164,21 +161,11 @@ struct std::hash<GC::Recipe>
 {
     std::size_t operator()(GC::Recipe const& individual) const noexcept
     {
-        auto TCodeAsInt = [&](const GC::TCode tCode) -> size_t {return (size_t)tCode;};
-        auto CCodeAsInt = [&](const GC::CCode cCode) -> size_t {return (size_t)cCode;};
-
-        size_t accumulator = 0;
-        auto combineWithValue = [&](const size_t val) {
-            accumulator = (accumulator<<4)^val;
-        };
-
-        combineWithValue(CCodeAsInt(individual.cCode));
-        std::for_each(individual.tList.begin(), individual.tList.end(), [&](auto tCode) {
-            combineWithValue(TCodeAsInt(tCode));
-        });
-
-        return accumulator;
-
+        //the transforms are already packed in two words, so this just mixes them with the compression code
+        uint64_t x = individual.tList.getFirstWord() ^ ((individual.tList.getSecondWord() + (uint64_t)individual.cCode) * 0x9E3779B97F4A7C15ULL);
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
     }
 };
 
@@ -20,7 +20,18 @@ namespace GC {
         T_SubtractXORAverageTransform,
         T_LempelZivWelchTransform,
         T_BurrowsWheelerTransform,
-        T_SubMinAdaptiveTransform
+        T_SubMinAdaptiveTransform,
+        T_BlockSortingTransform,
+        T_StrideTransform_8,
+        T_DeltaTransform_16,
+        T_DeltaTransform_32,
+        T_DeltaTransform_64,
+        T_DeltaXORTransform_16,
+        T_DeltaXORTransform_32,
+        T_DeltaXORTransform_64,
+        T_StrideTransform_12,
+        T_StrideTransform_16,
+        T_AmountOfTCodes //not a transform, it's always last so that it counts the codes above
     };
 
     const std::vector<std::string> TCodesAsStrings = {
@@ -37,7 +48,17 @@ namespace GC {
             "SBXAV",   //subtract xor average transform
             "LZWv5",     //lempel ziv welch version 5
             "BWTra",     //Burrows Wheeler Transform
-            "SubMA" //Subtract Minimum Adaptive Transform
+            "SubMA", //Subtract Minimum Adaptive Transform
+            "BSORT",  //Block sorting: BWT, move to front and zero run length in one stage
+            "STRD8",  //stride 8, for doubles and 64 bit integers
+            "DLT16",  //delta on little endian 16 bit words
+            "DLT32",
+            "DLT64",
+            "DXR16",  //delta xor on little endian 16 bit words
+            "DXR32",
+            "DXR64",
+            "STR12",  //stride 12, eg for rgb floats
+            "STR16"
     };
 
     const std::vector<TCode> availableTCodes = {T_IdentityTransform,
@@ -53,7 +74,44 @@ namespace GC {
                                                 T_SubtractXORAverageTransform,
                                                 T_LempelZivWelchTransform,
                                                 T_BurrowsWheelerTransform,
-                                                T_SubMinAdaptiveTransform};
+                                                T_SubMinAdaptiveTransform,
+                                                T_BlockSortingTransform,
+                                                T_StrideTransform_8,
+                                                T_DeltaTransform_16,
+                                                T_DeltaTransform_32,
+                                                T_DeltaTransform_64,
+                                                T_DeltaXORTransform_16,
+                                                T_DeltaXORTransform_32,
+                                                T_DeltaXORTransform_64,
+                                                T_StrideTransform_12,
+                                                T_StrideTransform_16};
+
+    /**
+     * Some transforms are a family with a parameter, and in a file (from format version 1) they are stored as
+     * the code of the family (its first member) followed by the parameter, so that new parameters don't need new codes in the format.
+     * The transforms which are not in this list are stored as their own code, with no parameter.
+     */
+    struct ParameterisedTCode {
+        TCode tCode;
+        TCode family;
+        size_t parameter;
+    };
+
+    const std::vector<ParameterisedTCode> parameterisedTCodes = {
+            {T_DeltaTransform,       T_DeltaTransform,    1}, //the parameter is the lane size in units
+            {T_DeltaTransform_16,    T_DeltaTransform,    2},
+            {T_DeltaTransform_32,    T_DeltaTransform,    4},
+            {T_DeltaTransform_64,    T_DeltaTransform,    8},
+            {T_DeltaXORTransform,    T_DeltaXORTransform, 1},
+            {T_DeltaXORTransform_16, T_DeltaXORTransform, 2},
+            {T_DeltaXORTransform_32, T_DeltaXORTransform, 4},
+            {T_DeltaXORTransform_64, T_DeltaXORTransform, 8},
+            {T_StrideTransform_2,    T_StrideTransform_2, 2}, //the parameter is the stride
+            {T_StrideTransform_3,    T_StrideTransform_2, 3},
+            {T_StrideTransform_4,    T_StrideTransform_2, 4},
+            {T_StrideTransform_8,    T_StrideTransform_2, 8},
+            {T_StrideTransform_12,   T_StrideTransform_2, 12},
+            {T_StrideTransform_16,   T_StrideTransform_2, 16}};
 
 
 }
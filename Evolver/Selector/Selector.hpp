@@ -6,17 +6,21 @@
 #define DISS_SIMPLEPROTOTYPE_SELECTOR_HPP
 #include <vector>
 #include "../Recipe/Recipe.hpp"
-#include "../../Random/RandomElement.hpp"
+#include "../../Random/RandomInt.hpp"
 #include "../../Utilities/utilities.hpp"
 #include "../Evaluator/Evaluator.hpp"
 #include "../../names.hpp"
 #include <sstream>
+#include <numeric>
 
 namespace GC {
 
     /**
      * This class will hold a pool of individuals, and will be used to select them, based on their fitness
      * It does not care about how the fitness is stored or calculated, and just assumes that the individuals will always have a fitness score precalculated and embedded in them
+     *
+     * The pool is not copied: the selector refers to the population (which must outlive the selections) and keeps an array of its fitnesses,
+     * so a tournament is just some random indexes and comparisons.
      */
     class Selector {
     public:
@@ -36,10 +40,12 @@ namespace GC {
 
         using SelectionKind = std::variant<TournamentSelection, FitnessProportionateSelection>;
     private:
-        std::vector<Recipe> pool;
+        const std::vector<Recipe>* pool = nullptr;
+        std::vector<Fitness> poolFitnesses;
+        size_t tournamentSize = 1;
         SelectionKind selectionKind;
 
-        RandomElement<Recipe> randomIndividualChooser;
+        RandomInt<size_t> randomIndexChooser;
 
     public:
 
@@ -78,13 +84,16 @@ namespace GC {
             return ss.str();
         }
 
-        template <class List>
-        void preparePool(const List& totalPopulation) {
+        void preparePool(const std::vector<Recipe>& totalPopulation) {
             //LOG("Preparing the population");
             if (isTournamentSelection()) {
                 //LOG("(Using tournament selection)");
-                //there's nothing special to do...
-                pool = totalPopulation;
+                ASSERT_NOT_EMPTY(totalPopulation);
+                pool = &totalPopulation;
+                poolFitnesses.clear();
+                for (const Recipe& individual: totalPopulation) poolFitnesses.push_back(individual.getFitness());
+                randomIndexChooser.setBounds(0, totalPopulation.size()-1);
+                tournamentSize = std::max<size_t>(getTournamentProportion()*(double)totalPopulation.size(), 1);
             }
             else if (isFitnessProportionateSelection()) {
                 ERROR_NOT_IMPLEMENTED("FitnessProportionateSelection is not implemented yet!");
@@ -94,25 +103,42 @@ namespace GC {
             }
         }
 
-        Recipe select() {
+        /**
+         * @return the index in the prepared pool of the selected individual
+         */
+        size_t selectIndex() {
             if (isTournamentSelection())
                 return tournamentSelect();
             else {
                 ERROR_NOT_IMPLEMENTED("The requested selection kind is not implemented yet!");
-                return {};
+                return 0;
             }
         }
 
+        /**
+         * @return a reference into the prepared pool, valid as long as the population given to preparePool
+         */
+        const Recipe& select() {
+            return (*pool)[selectIndex()];
+        }
+
+        size_t getTournamentSize() const {
+            return tournamentSize;
+        }
+
 
         std::vector<Recipe> selectElite(const size_t amount, const std::vector<Recipe>& pool) {
-            auto isIndividualBetter = [&](const Recipe& A, const Recipe& B) {
-                return A.getFitness() < B.getFitness();
-            };
             ASSERT(pool.size() >= amount);
+            std::vector<size_t> indexes(pool.size());
+            std::iota(indexes.begin(), indexes.end(), 0);
+            auto isIndividualBetter = [&](const size_t A, const size_t B) {
+                return pool[A].getFitness() < pool[B].getFitness();
+            };
 
-            auto copyOfPool = pool;
-            std::nth_element(copyOfPool.begin(), copyOfPool.begin()+amount, copyOfPool.end(), isIndividualBetter);
-            std::vector<Recipe> result(copyOfPool.begin(), copyOfPool.begin() + amount);
+            std::nth_element(indexes.begin(), indexes.begin()+amount, indexes.end(), isIndividualBetter);
+            std::vector<Recipe> result;
+            result.reserve(amount);
+            for (size_t i=0;i<amount;i++) result.push_back(pool[indexes[i]]);
 
             return result;
         }
@@ -120,20 +146,13 @@ namespace GC {
 
     private:
 
-        Recipe tournamentSelect() {
-            std::vector<Recipe> tournament;//TODO: this copies the individuals into the tournament, which is very inefficient, in the future this should just reference them in some way
-            randomIndividualChooser.setElementPool(pool);
-            auto addRandomIndividual = [&]() {
-                tournament.push_back(randomIndividualChooser.choose());
-            };
-
-            size_t howManyToSelect = (double)(getTournamentProportion()*(double)pool.size());
-            ////LOG("proportion is ", getTournamentProportion(), ", will select", howManyToSelect, "individuals, from the pool of size", pool.size());
-            repeat(howManyToSelect, addRandomIndividual);
-
-
-            auto getFitness = [&](const Recipe& i) -> Fitness {return i.getFitness();};
-            return getMinimumBy(tournament, getFitness);
+        size_t tournamentSelect() {
+            size_t winner = randomIndexChooser.choose();
+            for (size_t i=1;i<tournamentSize;i++) {
+                const size_t contender = randomIndexChooser.choose();
+                if (poolFitnesses[contender] < poolFitnesses[winner]) winner = contender;
+            }
+            return winner;
         }
 
 
@@ -152,7 +171,7 @@ namespace GC {
 
         void LOGPool() {
             LOG("The pool in this selector is");
-            for (auto ind: pool) {LOG(ind.to_string());}
+            for (const Recipe& ind: *pool) {LOG(ind.to_string());}
             LOG("----------end of pool-----------------");
         }
     };
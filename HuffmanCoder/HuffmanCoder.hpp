@@ -206,7 +206,7 @@ namespace GC {
             using EncoderMap = std::map<Symbol, BitVector>;
             using Handler = std::function<void(const std::vector<bool>&)>;
             const EncoderMap& map;
-            const Handler& handler;
+            const Handler handler; //by value, getEncoder receives the handler as a temporary
 
             Encoder(const EncoderMap& _map, const Handler& _handler) : map(_map), handler(_handler){}
             void encodeSymbol(const Symbol& symbol) const {
@@ -0,0 +1,261 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "DeltaKernels.hpp"
+#include "../Utilities/utilities.hpp"
+#include <cstdint>
+#include <cstring>
+
+#if GC_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace GC {
+
+    namespace {
+        template <size_t L> struct LaneWord;
+        template <> struct LaneWord<1> { using Type = uint8_t; };
+        template <> struct LaneWord<2> { using Type = uint16_t; };
+        template <> struct LaneWord<4> { using Type = uint32_t; };
+        template <> struct LaneWord<8> { using Type = uint64_t; };
+
+        //the words are little endian, which is also the layout of every cpu that has the vector kernels
+        template <size_t L>
+        inline typename LaneWord<L>::Type loadWord(const Unit* position) {
+            typename LaneWord<L>::Type word;
+            std::memcpy(&word, position, L);
+            return word;
+        }
+
+        template <size_t L>
+        inline void storeWord(Unit* position, const typename LaneWord<L>::Type word) {
+            std::memcpy(position, &word, L);
+        }
+
+        template <size_t L, bool isXOR>
+        inline typename LaneWord<L>::Type combine(const typename LaneWord<L>::Type a, const typename LaneWord<L>::Type b) {
+            return isXOR ? (a ^ b) : (typename LaneWord<L>::Type)(a + b);
+        }
+
+        template <size_t L, bool isXOR>
+        inline typename LaneWord<L>::Type separate(const typename LaneWord<L>::Type a, const typename LaneWord<L>::Type b) {
+            return isXOR ? (a ^ b) : (typename LaneWord<L>::Type)(a - b);
+        }
+
+        //the units after the last complete word are left as they are
+        inline void copyTrailingUnits(const Unit* input, Unit* output, const size_t size, const size_t laneSize) {
+            const size_t tail = size - (size/laneSize)*laneSize;
+            if (tail > 0 && input != output)
+                std::memcpy(output+size-tail, input+size-tail, tail);
+        }
+
+        //encodes the words in [0, end), where end is in units and a multiple of L
+        template <size_t L, bool isXOR>
+        void encodeScalar(const Unit* input, Unit* output, const size_t end) {
+            //goes backwards, so that it works in place
+            for (size_t i = end-L; i > 0; i -= L)
+                storeWord<L>(output+i, separate<L, isXOR>(loadWord<L>(input+i), loadWord<L>(input+i-L)));
+            storeWord<L>(output, loadWord<L>(input));
+        }
+
+        //decodes the words in [start, end), start and end are in units and multiples of L
+        template <size_t L, bool isXOR>
+        void decodeScalar(const Unit* input, Unit* output, const size_t end, const size_t start) {
+            typename LaneWord<L>::Type running = (start == 0) ? 0 : loadWord<L>(output+start-L);
+            for (size_t i = start; i < end; i += L) {
+                running = combine<L, isXOR>(running, loadWord<L>(input+i));
+                storeWord<L>(output+i, running);
+            }
+        }
+
+        inline size_t wordsEnd(const size_t size, const size_t laneSize) { return (size/laneSize)*laneSize; }
+
+        template <size_t L, bool isXOR>
+        void encode_Scalar(const Unit* input, Unit* output, const size_t size) {
+            const size_t end = wordsEnd(size, L);
+            if (end > 0) encodeScalar<L, isXOR>(input, output, end);
+            copyTrailingUnits(input, output, size, L);
+        }
+
+        template <size_t L, bool isXOR>
+        void decode_Scalar(const Unit* input, Unit* output, const size_t size) {
+            decodeScalar<L, isXOR>(input, output, wordsEnd(size, L), 0);
+            copyTrailingUnits(input, output, size, L);
+        }
+
+#if GC_X86_KERNELS
+
+        template <size_t L, bool isXOR>
+        __attribute__((target("sse4.1")))
+        inline __m128i combine128(const __m128i a, const __m128i b) {
+            if constexpr (isXOR) return _mm_xor_si128(a, b);
+            else if constexpr (L == 1) return _mm_add_epi8(a, b);
+            else if constexpr (L == 2) return _mm_add_epi16(a, b);
+            else if constexpr (L == 4) return _mm_add_epi32(a, b);
+            else return _mm_add_epi64(a, b);
+        }
+
+        template <size_t L, bool isXOR>
+        __attribute__((target("sse4.1")))
+        inline __m128i separate128(const __m128i a, const __m128i b) {
+            if constexpr (isXOR) return _mm_xor_si128(a, b);
+            else if constexpr (L == 1) return _mm_sub_epi8(a, b);
+            else if constexpr (L == 2) return _mm_sub_epi16(a, b);
+            else if constexpr (L == 4) return _mm_sub_epi32(a, b);
+            else return _mm_sub_epi64(a, b);
+        }
+
+        //log-step prefix scan within each 128 bit lane, ie shifts by L, 2L, 4L.. bytes
+        template <size_t L, bool isXOR, size_t shift = L>
+        __attribute__((target("sse4.1")))
+        inline __m128i prefixScan128(const __m128i x) {
+            if constexpr (shift < 16) return prefixScan128<L, isXOR, shift*2>(combine128<L, isXOR>(x, _mm_slli_si128(x, shift)));
+            else return x;
+        }
+
+        //a pshufb mask that broadcasts the last word of each 128 bit lane
+        template <size_t L>
+        __attribute__((target("sse4.1")))
+        inline __m128i lastWordMask128() {
+            alignas(16) int8_t mask[16];
+            for (size_t i = 0; i < 16; i++) mask[i] = (int8_t)(16-L+(i%L));
+            return _mm_load_si128((const __m128i*)mask);
+        }
+
+        template <size_t L, bool isXOR>
+        __attribute__((target("sse4.1")))
+        void encode_SSE4(const Unit* input, Unit* output, const size_t size) {
+            constexpr size_t width = 16;
+            const size_t wordsSize = wordsEnd(size, L);
+            size_t end = wordsSize;
+            while (end >= width+L) { //every register needs the word before it, so word 0 is always left to the scalar part
+                const size_t i = end-width;
+                const __m128i current = _mm_loadu_si128((const __m128i*)(input+i));
+                const __m128i previous = _mm_loadu_si128((const __m128i*)(input+i-L));
+                _mm_storeu_si128((__m128i*)(output+i), separate128<L, isXOR>(current, previous));
+                end = i;
+            }
+            if (end > 0) encodeScalar<L, isXOR>(input, output, end);
+            copyTrailingUnits(input, output, size, L);
+        }
+
+        template <size_t L, bool isXOR>
+        __attribute__((target("sse4.1")))
+        void decode_SSE4(const Unit* input, Unit* output, const size_t size) {
+            constexpr size_t width = 16;
+            const size_t wordsSize = wordsEnd(size, L);
+            const __m128i lastWord = lastWordMask128<L>();
+            __m128i carry = _mm_setzero_si128();
+            size_t i = 0;
+            for (; i+width <= wordsSize; i += width) {
+                __m128i x = prefixScan128<L, isXOR>(_mm_loadu_si128((const __m128i*)(input+i)));
+                x = combine128<L, isXOR>(x, carry);
+                _mm_storeu_si128((__m128i*)(output+i), x);
+                carry = _mm_shuffle_epi8(x, lastWord);
+            }
+            decodeScalar<L, isXOR>(input, output, wordsSize, i);
+            copyTrailingUnits(input, output, size, L);
+        }
+
+        template <size_t L, bool isXOR>
+        __attribute__((target("avx2")))
+        inline __m256i combine256(const __m256i a, const __m256i b) {
+            if constexpr (isXOR) return _mm256_xor_si256(a, b);
+            else if constexpr (L == 1) return _mm256_add_epi8(a, b);
+            else if constexpr (L == 2) return _mm256_add_epi16(a, b);
+            else if constexpr (L == 4) return _mm256_add_epi32(a, b);
+            else return _mm256_add_epi64(a, b);
+        }
+
+        template <size_t L, bool isXOR>
+        __attribute__((target("avx2")))
+        inline __m256i separate256(const __m256i a, const __m256i b) {
+            if constexpr (isXOR) return _mm256_xor_si256(a, b);
+            else if constexpr (L == 1) return _mm256_sub_epi8(a, b);
+            else if constexpr (L == 2) return _mm256_sub_epi16(a, b);
+            else if constexpr (L == 4) return _mm256_sub_epi32(a, b);
+            else return _mm256_sub_epi64(a, b);
+        }
+
+        template <size_t L, bool isXOR, size_t shift = L>
+        __attribute__((target("avx2")))
+        inline __m256i prefixScan256(const __m256i x) {
+            if constexpr (shift < 16) return prefixScan256<L, isXOR, shift*2>(combine256<L, isXOR>(x, _mm256_slli_si256(x, shift)));
+            else return x;
+        }
+
+        template <size_t L, bool isXOR>
+        __attribute__((target("avx2")))
+        void encode_AVX2(const Unit* input, Unit* output, const size_t size) {
+            constexpr size_t width = 32;
+            size_t end = wordsEnd(size, L);
+            while (end >= width+L) {
+                const size_t i = end-width;
+                const __m256i current = _mm256_loadu_si256((const __m256i*)(input+i));
+                const __m256i previous = _mm256_loadu_si256((const __m256i*)(input+i-L));
+                _mm256_storeu_si256((__m256i*)(output+i), separate256<L, isXOR>(current, previous));
+                end = i;
+            }
+            if (end > 0) encode_SSE4<L, isXOR>(input, output, end);
+            copyTrailingUnits(input, output, size, L);
+        }
+
+        template <size_t L, bool isXOR>
+        __attribute__((target("avx2")))
+        void decode_AVX2(const Unit* input, Unit* output, const size_t size) {
+            constexpr size_t width = 32;
+            const size_t wordsSize = wordsEnd(size, L);
+            const __m256i lastWordOfLane = _mm256_broadcastsi128_si256(lastWordMask128<L>());
+            __m256i carry = _mm256_setzero_si256();
+            size_t i = 0;
+            for (; i+width <= wordsSize; i += width) {
+                //the byte shifts only work within each 128 bit lane..
+                __m256i x = prefixScan256<L, isXOR>(_mm256_loadu_si256((const __m256i*)(input+i)));
+                //..so the total of the low lane is then carried into the high lane
+                const __m256i laneTotals = _mm256_shuffle_epi8(x, lastWordOfLane);
+                x = combine256<L, isXOR>(x, _mm256_permute2x128_si256(laneTotals, laneTotals, 0x08));
+                x = combine256<L, isXOR>(x, carry);
+                _mm256_storeu_si256((__m256i*)(output+i), x);
+                const __m256i totals = _mm256_shuffle_epi8(x, lastWordOfLane);
+                carry = _mm256_permute2x128_si256(totals, totals, 0x11);
+            }
+            decodeScalar<L, isXOR>(input, output, wordsSize, i);
+            copyTrailingUnits(input, output, size, L);
+        }
+#endif
+
+        template <size_t L>
+        const DeltaKernels& getLaneDeltaKernels(const SIMDLevel level) {
+            static const DeltaKernels scalar = {encode_Scalar<L, false>, decode_Scalar<L, false>, encode_Scalar<L, true>, decode_Scalar<L, true>};
+#if GC_X86_KERNELS
+            static const DeltaKernels sse4 = {encode_SSE4<L, false>, decode_SSE4<L, false>, encode_SSE4<L, true>, decode_SSE4<L, true>};
+            static const DeltaKernels avx2 = {encode_AVX2<L, false>, decode_AVX2<L, false>, encode_AVX2<L, true>, decode_AVX2<L, true>};
+            switch (level) {
+                case SIMDLevel::AVX2: return avx2;
+                case SIMDLevel::SSE4: return sse4;
+                default: return scalar;
+            }
+#else
+            return scalar;
+#endif
+        }
+    }
+
+    const DeltaKernels& getDeltaKernels(const SIMDLevel level, const size_t laneSize) {
+        switch (laneSize) {
+            case 1: return getLaneDeltaKernels<1>(level);
+            case 2: return getLaneDeltaKernels<2>(level);
+            case 4: return getLaneDeltaKernels<4>(level);
+            case 8: return getLaneDeltaKernels<8>(level);
+            default: ERROR_NOT_IMPLEMENTED("Delta kernels only exist for lanes of 1, 2, 4 and 8 units");
+        }
+        return getLaneDeltaKernels<1>(level);
+    }
+
+    const DeltaKernels& getDeltaKernels(const size_t laneSize) {
+        static const SIMDLevel best = getBestSIMDLevel();
+        return getDeltaKernels(best, laneSize);
+    }
+
+} // GC
@@ -0,0 +1,44 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_DELTAKERNELS_HPP
+#define EVOCOM_DELTAKERNELS_HPP
+
+#include <cstddef>
+#include "../names.hpp"
+#include "SIMDSupport.hpp"
+
+namespace GC {
+
+    /**
+     * The kernels used by DeltaTransform, DeltaXORTransform and LaneDeltaTransform.
+     * Every kernel takes (input, output, size), where output[0] = input[0] and the rest is computed as follows
+     *    encode:  output[i] = input[i] - input[i-1]   (or ^ for the xor kernels)
+     *    decode:  output[i] = output[i-1] + input[i]  (a prefix sum, or a prefix xor)
+     * input and output may be the same pointer, which is how the transforms work in place.
+     *
+     * With a lane size above 1, the elements are the little endian words of 2, 4 or 8 units, and size is still in units.
+     * The units after the last complete word are copied unchanged.
+     *
+     * The vector versions encode with a shifted subtract, and decode with a log-step prefix scan inside the register,
+     * followed by adding the last value of the previous register to every lane.
+     */
+    struct DeltaKernels {
+        using Kernel = void (*)(const Unit* input, Unit* output, size_t size);
+        Kernel deltaEncode;
+        Kernel deltaDecode;
+        Kernel xorEncode;
+        Kernel xorDecode;
+    };
+
+    const DeltaKernels& getDeltaKernels(const SIMDLevel level, const size_t laneSize = 1);
+
+    /**
+     * @return the kernels for the best level supported by this cpu
+     */
+    const DeltaKernels& getDeltaKernels(const size_t laneSize = 1);
+
+} // GC
+
+#endif //EVOCOM_DELTAKERNELS_HPP
@@ -0,0 +1,112 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "OffsetKernels.hpp"
+#include <algorithm>
+
+#if GC_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace GC {
+
+    namespace {
+        template <bool isSubtraction>
+        void offsetScalar(const Unit* input, Unit* output, const size_t size, const Unit offset, const size_t start) {
+            for (size_t i = start; i < size; i++)
+                output[i] = isSubtraction ? (Unit)(input[i]-offset) : (Unit)(input[i]+offset);
+        }
+
+        template <bool isSubtraction>
+        void offset_Scalar(const Unit* input, Unit* output, const size_t size, const Unit offset) {
+            offsetScalar<isSubtraction>(input, output, size, offset, 0);
+        }
+
+        Unit minimumScalar(const Unit* data, const size_t size, const size_t start, Unit current) {
+            for (size_t i = start; i < size; i++)
+                current = std::min(current, data[i]);
+            return current;
+        }
+
+        Unit minimum_Scalar(const Unit* data, const size_t size) {
+            return minimumScalar(data, size, 0, 0xFF);
+        }
+
+#if GC_X86_KERNELS
+
+        template <bool isSubtraction>
+        __attribute__((target("sse4.1")))
+        void offset_SSE4(const Unit* input, Unit* output, const size_t size, const Unit offset) {
+            constexpr size_t width = 16;
+            const __m128i offsets = _mm_set1_epi8((char)offset);
+            size_t i = 0;
+            for (; i+width <= size; i += width) {
+                const __m128i x = _mm_loadu_si128((const __m128i*)(input+i));
+                _mm_storeu_si128((__m128i*)(output+i), isSubtraction ? _mm_sub_epi8(x, offsets) : _mm_add_epi8(x, offsets));
+            }
+            offsetScalar<isSubtraction>(input, output, size, offset, i);
+        }
+
+        __attribute__((target("sse4.1")))
+        Unit minimum_SSE4(const Unit* data, const size_t size) {
+            constexpr size_t width = 16;
+            __m128i minimums = _mm_set1_epi8((char)0xFF);
+            size_t i = 0;
+            for (; i+width <= size; i += width)
+                minimums = _mm_min_epu8(minimums, _mm_loadu_si128((const __m128i*)(data+i)));
+            //phminposuw finds the minimum of 8 words, so the bytes are first reduced to words
+            minimums = _mm_min_epu8(minimums, _mm_srli_epi16(minimums, 8));
+            const Unit vectorMinimum = (Unit)_mm_cvtsi128_si32(_mm_minpos_epu16(_mm_and_si128(minimums, _mm_set1_epi16(0xFF))));
+            return minimumScalar(data, size, i, vectorMinimum);
+        }
+
+        template <bool isSubtraction>
+        __attribute__((target("avx2")))
+        void offset_AVX2(const Unit* input, Unit* output, const size_t size, const Unit offset) {
+            constexpr size_t width = 32;
+            const __m256i offsets = _mm256_set1_epi8((char)offset);
+            size_t i = 0;
+            for (; i+width <= size; i += width) {
+                const __m256i x = _mm256_loadu_si256((const __m256i*)(input+i));
+                _mm256_storeu_si256((__m256i*)(output+i), isSubtraction ? _mm256_sub_epi8(x, offsets) : _mm256_add_epi8(x, offsets));
+            }
+            offset_SSE4<isSubtraction>(input+i, output+i, size-i, offset);
+        }
+
+        __attribute__((target("avx2")))
+        Unit minimum_AVX2(const Unit* data, const size_t size) {
+            constexpr size_t width = 32;
+            __m256i minimums = _mm256_set1_epi8((char)0xFF);
+            size_t i = 0;
+            for (; i+width <= size; i += width)
+                minimums = _mm256_min_epu8(minimums, _mm256_loadu_si256((const __m256i*)(data+i)));
+            alignas(32) Unit lanes[width];
+            _mm256_store_si256((__m256i*)lanes, minimums);
+            const Unit vectorMinimum = std::min(minimum_SSE4(lanes, 16), minimum_SSE4(lanes+16, 16));
+            return std::min(vectorMinimum, minimum_SSE4(data+i, size-i));
+        }
+#endif
+    }
+
+    const OffsetKernels& getOffsetKernels(const SIMDLevel level) {
+        static const OffsetKernels scalar = {offset_Scalar<true>, offset_Scalar<false>, minimum_Scalar};
+#if GC_X86_KERNELS
+        static const OffsetKernels sse4 = {offset_SSE4<true>, offset_SSE4<false>, minimum_SSE4};
+        static const OffsetKernels avx2 = {offset_AVX2<true>, offset_AVX2<false>, minimum_AVX2};
+        switch (level) {
+            case SIMDLevel::AVX2: return avx2;
+            case SIMDLevel::SSE4: return sse4;
+            default: return scalar;
+        }
+#else
+        return scalar;
+#endif
+    }
+
+    const OffsetKernels& getOffsetKernels() {
+        static const OffsetKernels& best = getOffsetKernels(getBestSIMDLevel());
+        return best;
+    }
+
+} // GC
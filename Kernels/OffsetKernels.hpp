@@ -0,0 +1,38 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_OFFSETKERNELS_HPP
+#define EVOCOM_OFFSETKERNELS_HPP
+
+#include <cstddef>
+#include "../names.hpp"
+#include "SIMDSupport.hpp"
+
+namespace GC {
+
+    /**
+     * The kernels used by SubMinAdaptiveTransform, which subtracts the minimum of each subsegment from its units.
+     *    subtractOffset(input, output, size, offset): output[i] = input[i] - offset
+     *    addOffset(input, output, size, offset):      output[i] = input[i] + offset
+     *    minimum(data, size): the smallest unit, or the largest possible unit when size is 0
+     * input and output may be the same pointer.
+     */
+    struct OffsetKernels {
+        using Kernel = void (*)(const Unit* input, Unit* output, size_t size, Unit offset);
+        using Minimum = Unit (*)(const Unit* data, size_t size);
+        Kernel subtractOffset;
+        Kernel addOffset;
+        Minimum minimum;
+    };
+
+    const OffsetKernels& getOffsetKernels(const SIMDLevel level);
+
+    /**
+     * @return the kernels for the best level supported by this cpu
+     */
+    const OffsetKernels& getOffsetKernels();
+
+} // GC
+
+#endif //EVOCOM_OFFSETKERNELS_HPP
@@ -0,0 +1,113 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "RunKernels.hpp"
+
+#if GC_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace GC {
+
+    namespace {
+        size_t findRunEnd_Scalar(const Unit* data, const size_t start, const size_t size) {
+            const Unit repeated = data[start];
+            size_t i = start+1;
+            while (i < size && data[i] == repeated) i++;
+            return i;
+        }
+
+        size_t countChanges(const Unit* data, const size_t from, const size_t size) {
+            size_t changes = 0;
+            for (size_t i = from; i < size; i++)
+                changes += data[i] != data[i-1];
+            return changes;
+        }
+
+        size_t countRuns_Scalar(const Unit* data, const size_t size) {
+            if (size == 0) return 0;
+            return 1+countChanges(data, 1, size);
+        }
+
+#if GC_X86_KERNELS
+
+        __attribute__((target("sse4.1")))
+        size_t findRunEnd_SSE4(const Unit* data, const size_t start, const size_t size) {
+            constexpr size_t width = 16;
+            const __m128i repeated = _mm_set1_epi8((char)data[start]);
+            size_t i = start+1;
+            for (; i+width <= size; i += width) {
+                const __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data+i)), repeated);
+                const unsigned mismatches = ~(unsigned)_mm_movemask_epi8(equal) & 0xFFFF;
+                if (mismatches != 0) return i+__builtin_ctz(mismatches);
+            }
+            return findRunEnd_Scalar(data, i-1, size); //data[i-1] is still part of the run
+        }
+
+        __attribute__((target("sse4.1")))
+        size_t countRuns_SSE4(const Unit* data, const size_t size) {
+            if (size == 0) return 0;
+            constexpr size_t width = 16;
+            size_t changes = 0;
+            size_t i = 1;
+            for (; i+width <= size; i += width) {
+                const __m128i current = _mm_loadu_si128((const __m128i*)(data+i));
+                const __m128i previous = _mm_loadu_si128((const __m128i*)(data+i-1));
+                const unsigned equal = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(current, previous));
+                changes += width-__builtin_popcount(equal);
+            }
+            return 1+changes+countChanges(data, i, size);
+        }
+
+        __attribute__((target("avx2")))
+        size_t findRunEnd_AVX2(const Unit* data, const size_t start, const size_t size) {
+            constexpr size_t width = 32;
+            const __m256i repeated = _mm256_set1_epi8((char)data[start]);
+            size_t i = start+1;
+            for (; i+width <= size; i += width) {
+                const __m256i equal = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data+i)), repeated);
+                const unsigned mismatches = ~(unsigned)_mm256_movemask_epi8(equal);
+                if (mismatches != 0) return i+__builtin_ctz(mismatches);
+            }
+            return findRunEnd_SSE4(data, i-1, size);
+        }
+
+        __attribute__((target("avx2,popcnt")))
+        size_t countRuns_AVX2(const Unit* data, const size_t size) {
+            if (size == 0) return 0;
+            constexpr size_t width = 32;
+            size_t changes = 0;
+            size_t i = 1;
+            for (; i+width <= size; i += width) {
+                const __m256i current = _mm256_loadu_si256((const __m256i*)(data+i));
+                const __m256i previous = _mm256_loadu_si256((const __m256i*)(data+i-1));
+                const unsigned equal = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(current, previous));
+                changes += width-__builtin_popcount(equal);
+            }
+            return 1+changes+countChanges(data, i, size);
+        }
+#endif
+    }
+
+    const RunKernels& getRunKernels(const SIMDLevel level) {
+        static const RunKernels scalar = {findRunEnd_Scalar, countRuns_Scalar};
+#if GC_X86_KERNELS
+        static const RunKernels sse4 = {findRunEnd_SSE4, countRuns_SSE4};
+        static const RunKernels avx2 = {findRunEnd_AVX2, countRuns_AVX2};
+        switch (level) {
+            case SIMDLevel::AVX2: return avx2;
+            case SIMDLevel::SSE4: return sse4;
+            default: return scalar;
+        }
+#else
+        return scalar;
+#endif
+    }
+
+    const RunKernels& getRunKernels() {
+        static const RunKernels& best = getRunKernels(getBestSIMDLevel());
+        return best;
+    }
+
+} // GC
@@ -0,0 +1,37 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_RUNKERNELS_HPP
+#define EVOCOM_RUNKERNELS_HPP
+
+#include <cstddef>
+#include "../names.hpp"
+#include "SIMDSupport.hpp"
+
+namespace GC {
+
+    /**
+     * The kernels used to find runs, by RunLengthTransform and NRLCompression.
+     *    findRunEnd(data, start, size): the first index >= start where the unit differs from data[start], or size if there is none
+     *    countRuns(data, size): the amount of maximal runs, ie 1 + the amount of i where data[i] != data[i-1] (0 when empty)
+     *
+     * The vector versions compare 16 or 32 units at a time, and use movemask with ctz (or popcount) on the result.
+     */
+    struct RunKernels {
+        using FindRunEnd = size_t (*)(const Unit* data, size_t start, size_t size);
+        using CountRuns = size_t (*)(const Unit* data, size_t size);
+        FindRunEnd findRunEnd;
+        CountRuns countRuns;
+    };
+
+    const RunKernels& getRunKernels(const SIMDLevel level);
+
+    /**
+     * @return the kernels for the best level supported by this cpu
+     */
+    const RunKernels& getRunKernels();
+
+} // GC
+
+#endif //EVOCOM_RUNKERNELS_HPP
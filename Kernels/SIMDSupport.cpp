@@ -0,0 +1,43 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "SIMDSupport.hpp"
+#include <cstdlib>
+
+namespace GC {
+
+    static SIMDLevel detectSIMDLevel() {
+        if (std::getenv("GC_SCALAR_KERNELS") != nullptr)
+            return SIMDLevel::Scalar;
+#if GC_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return SIMDLevel::AVX2;
+        if (__builtin_cpu_supports("sse4.1")) return SIMDLevel::SSE4;
+#endif
+        return SIMDLevel::Scalar;
+    }
+
+    SIMDLevel getBestSIMDLevel() {
+        static const SIMDLevel bestLevel = detectSIMDLevel();
+        return bestLevel;
+    }
+
+    std::vector<SIMDLevel> getSupportedSIMDLevels() {
+        std::vector<SIMDLevel> result = {SIMDLevel::Scalar};
+        const SIMDLevel best = getBestSIMDLevel();
+        if (best >= SIMDLevel::SSE4) result.push_back(SIMDLevel::SSE4);
+        if (best >= SIMDLevel::AVX2) result.push_back(SIMDLevel::AVX2);
+        return result;
+    }
+
+    std::string SIMDLevel_as_string(const SIMDLevel level) {
+        switch (level) {
+            case SIMDLevel::Scalar: return "Scalar";
+            case SIMDLevel::SSE4:   return "SSE4";
+            case SIMDLevel::AVX2:   return "AVX2";
+        }
+        return "Unknown";
+    }
+
+} // GC
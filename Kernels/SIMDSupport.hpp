@@ -0,0 +1,41 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_SIMDSUPPORT_HPP
+#define EVOCOM_SIMDSUPPORT_HPP
+
+#include <vector>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GC_X86_KERNELS 1
+#else
+#define GC_X86_KERNELS 0
+#endif
+
+namespace GC {
+
+    /**
+     * The instruction sets that the kernels can be compiled for.
+     * The kernels are compiled with function-level target attributes, so the whole project can still be built without -march,
+     * and the best level is chosen at runtime.
+     */
+    enum class SIMDLevel {Scalar, SSE4, AVX2};
+
+    /**
+     * Checks the cpu once, and returns the best level it supports.
+     * Setting the environment variable GC_SCALAR_KERNELS forces the scalar fallback (useful for comparisons)
+     */
+    SIMDLevel getBestSIMDLevel();
+
+    /**
+     * @return all the levels supported by this cpu, from Scalar to the best one. Mainly used for testing
+     */
+    std::vector<SIMDLevel> getSupportedSIMDLevels();
+
+    std::string SIMDLevel_as_string(const SIMDLevel level);
+
+} // GC
+
+#endif //EVOCOM_SIMDSUPPORT_HPP
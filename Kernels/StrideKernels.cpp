@@ -0,0 +1,315 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "StrideKernels.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#if GC_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace GC {
+
+    namespace {
+        inline size_t separationStart(const size_t separation, const size_t stride, const size_t size) {
+            return separation*(size/stride)+std::min(separation, size%stride);
+        }
+
+        //handles the records from firstRecord onwards, including the incomplete one at the end
+        void gatherScalar(const Unit* input, Unit* output, const size_t size, const size_t stride, const size_t firstRecord) {
+            const size_t records = size/stride;
+            const size_t remainder = size%stride;
+            for (size_t separation = 0; separation < stride; separation++) {
+                Unit* destination = output+separationStart(separation, stride, size);
+                const size_t end = records + (separation < remainder);
+                for (size_t record = firstRecord; record < end; record++)
+                    destination[record] = input[record*stride+separation];
+            }
+        }
+
+        void scatterScalar(const Unit* input, Unit* output, const size_t size, const size_t stride, const size_t firstRecord) {
+            const size_t records = size/stride;
+            const size_t remainder = size%stride;
+            for (size_t separation = 0; separation < stride; separation++) {
+                const Unit* source = input+separationStart(separation, stride, size);
+                const size_t end = records + (separation < remainder);
+                for (size_t record = firstRecord; record < end; record++)
+                    output[record*stride+separation] = source[record];
+            }
+        }
+
+#if GC_X86_KERNELS
+
+        constexpr bool isPowerOfTwo(const size_t x) { return (x & (x-1)) == 0; }
+
+        /**
+         * For strides that are not powers of two, each separation is assembled from all the registers of the block
+         * with one pshufb each (a mask index of -128 produces a zero, so the results can be or-ed together).
+         * gather[j][s] extracts the units of separation s from input register j,
+         * scatter[s][j] places the units of separation s in output register j
+         */
+        template <size_t S>
+        struct ShuffleMasks {
+            using Mask = std::array<int8_t, 16>;
+            std::array<std::array<Mask, S>, S> gather{};
+            std::array<std::array<Mask, S>, S> scatter{};
+
+            constexpr ShuffleMasks() {
+                for (size_t j = 0; j < S; j++)
+                    for (size_t s = 0; s < S; s++)
+                        for (size_t position = 0; position < 16; position++) {
+                            const size_t gatheredIndex = position*S+s;
+                            gather[j][s][position] = (gatheredIndex/16 == j) ? (int8_t)(gatheredIndex%16) : (int8_t)-128;
+                            const size_t scatteredIndex = j*16+position;
+                            scatter[s][j][position] = (scatteredIndex%S == s) ? (int8_t)(scatteredIndex/S) : (int8_t)-128;
+                        }
+            }
+        };
+
+        template <size_t S>
+        constexpr ShuffleMasks<S> shuffleMasks{};
+
+        template <size_t S>
+        __attribute__((target("sse4.1")))
+        inline void gatherByMasks128(__m128i* regs) {
+            __m128i result[S];
+            for (size_t s = 0; s < S; s++) {
+                result[s] = _mm_setzero_si128();
+                for (size_t j = 0; j < S; j++) {
+                    const __m128i mask = _mm_loadu_si128((const __m128i*)shuffleMasks<S>.gather[j][s].data());
+                    result[s] = _mm_or_si128(result[s], _mm_shuffle_epi8(regs[j], mask));
+                }
+            }
+            std::copy(result, result+S, regs);
+        }
+
+        template <size_t S>
+        __attribute__((target("sse4.1")))
+        inline void scatterByMasks128(__m128i* regs) {
+            __m128i result[S];
+            for (size_t j = 0; j < S; j++) {
+                result[j] = _mm_setzero_si128();
+                for (size_t s = 0; s < S; s++) {
+                    const __m128i mask = _mm_loadu_si128((const __m128i*)shuffleMasks<S>.scatter[s][j].data());
+                    result[j] = _mm_or_si128(result[j], _mm_shuffle_epi8(regs[s], mask));
+                }
+            }
+            std::copy(result, result+S, regs);
+        }
+
+        /**
+         * For power of two strides, the units are split into even and odd ones, and then each half is split again recursively.
+         * The even half holds the separations 0, 2, 4.. of the original, and the odd half holds 1, 3, 5..
+         * Everything happens in registers, the block is S registers of contiguous input on entry and S separations on exit.
+         */
+        template <size_t S>
+        __attribute__((target("sse4.1")))
+        inline void deinterleave128(__m128i* regs) {
+            if constexpr (S > 1) {
+                const __m128i evensThenOdds = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+                __m128i evens[S/2], odds[S/2];
+                for (size_t i = 0; i < S/2; i++) {
+                    const __m128i a = _mm_shuffle_epi8(regs[2*i], evensThenOdds);
+                    const __m128i b = _mm_shuffle_epi8(regs[2*i+1], evensThenOdds);
+                    evens[i] = _mm_unpacklo_epi64(a, b);
+                    odds[i] = _mm_unpackhi_epi64(a, b);
+                }
+                deinterleave128<S/2>(evens);
+                deinterleave128<S/2>(odds);
+                for (size_t i = 0; i < S/2; i++) {
+                    regs[2*i] = evens[i];
+                    regs[2*i+1] = odds[i];
+                }
+            }
+        }
+
+        template <size_t S>
+        __attribute__((target("sse4.1")))
+        inline void interleave128(__m128i* regs) {
+            if constexpr (S > 1) {
+                __m128i evens[S/2], odds[S/2];
+                for (size_t i = 0; i < S/2; i++) {
+                    evens[i] = regs[2*i];
+                    odds[i] = regs[2*i+1];
+                }
+                interleave128<S/2>(evens);
+                interleave128<S/2>(odds);
+                for (size_t i = 0; i < S/2; i++) {
+                    regs[2*i] = _mm_unpacklo_epi8(evens[i], odds[i]);
+                    regs[2*i+1] = _mm_unpackhi_epi8(evens[i], odds[i]);
+                }
+            }
+        }
+
+        template <size_t S>
+        __attribute__((target("sse4.1")))
+        void gather_SSE4(const Unit* input, Unit* output, const size_t size) {
+            constexpr size_t width = 16; //records per block
+            Unit* separations[S];
+            for (size_t s = 0; s < S; s++) separations[s] = output+separationStart(s, S, size);
+
+            const size_t records = size/S;
+            size_t record = 0;
+            for (; record+width <= records; record += width) {
+                __m128i regs[S];
+                for (size_t j = 0; j < S; j++) regs[j] = _mm_loadu_si128((const __m128i*)(input+record*S+j*16));
+                if constexpr (isPowerOfTwo(S)) deinterleave128<S>(regs);
+                else gatherByMasks128<S>(regs);
+                for (size_t s = 0; s < S; s++) _mm_storeu_si128((__m128i*)(separations[s]+record), regs[s]);
+            }
+            gatherScalar(input, output, size, S, record);
+        }
+
+        template <size_t S>
+        __attribute__((target("sse4.1")))
+        void scatter_SSE4(const Unit* input, Unit* output, const size_t size) {
+            constexpr size_t width = 16;
+            const Unit* separations[S];
+            for (size_t s = 0; s < S; s++) separations[s] = input+separationStart(s, S, size);
+
+            const size_t records = size/S;
+            size_t record = 0;
+            for (; record+width <= records; record += width) {
+                __m128i regs[S];
+                for (size_t s = 0; s < S; s++) regs[s] = _mm_loadu_si128((const __m128i*)(separations[s]+record));
+                if constexpr (isPowerOfTwo(S)) interleave128<S>(regs);
+                else scatterByMasks128<S>(regs);
+                for (size_t j = 0; j < S; j++) _mm_storeu_si128((__m128i*)(output+record*S+j*16), regs[j]);
+            }
+            scatterScalar(input, output, size, S, record);
+        }
+
+        //same as deinterleave128, but pshufb and the 64 bit unpacks work within each lane, so the quads are permuted to fix the order
+        template <size_t S>
+        __attribute__((target("avx2")))
+        inline void deinterleave256(__m256i* regs) {
+            if constexpr (S > 1) {
+                const __m256i evensThenOdds = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                                                               0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+                __m256i evens[S/2], odds[S/2];
+                for (size_t i = 0; i < S/2; i++) {
+                    //each becomes [evens | odds]
+                    const __m256i a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(regs[2*i], evensThenOdds), 0xD8);
+                    const __m256i b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(regs[2*i+1], evensThenOdds), 0xD8);
+                    evens[i] = _mm256_permute2x128_si256(a, b, 0x20);
+                    odds[i] = _mm256_permute2x128_si256(a, b, 0x31);
+                }
+                deinterleave256<S/2>(evens);
+                deinterleave256<S/2>(odds);
+                for (size_t i = 0; i < S/2; i++) {
+                    regs[2*i] = evens[i];
+                    regs[2*i+1] = odds[i];
+                }
+            }
+        }
+
+        template <size_t S>
+        __attribute__((target("avx2")))
+        inline void interleave256(__m256i* regs) {
+            if constexpr (S > 1) {
+                __m256i evens[S/2], odds[S/2];
+                for (size_t i = 0; i < S/2; i++) {
+                    evens[i] = regs[2*i];
+                    odds[i] = regs[2*i+1];
+                }
+                interleave256<S/2>(evens);
+                interleave256<S/2>(odds);
+                for (size_t i = 0; i < S/2; i++) {
+                    const __m256i low = _mm256_unpacklo_epi8(evens[i], odds[i]);
+                    const __m256i high = _mm256_unpackhi_epi8(evens[i], odds[i]);
+                    regs[2*i] = _mm256_permute2x128_si256(low, high, 0x20);
+                    regs[2*i+1] = _mm256_permute2x128_si256(low, high, 0x31);
+                }
+            }
+        }
+
+        template <size_t S>
+        __attribute__((target("avx2")))
+        void gather_AVX2(const Unit* input, Unit* output, const size_t size) {
+            static_assert(isPowerOfTwo(S));
+            constexpr size_t width = 32;
+            Unit* separations[S];
+            for (size_t s = 0; s < S; s++) separations[s] = output+separationStart(s, S, size);
+
+            const size_t records = size/S;
+            size_t record = 0;
+            for (; record+width <= records; record += width) {
+                __m256i regs[S];
+                for (size_t j = 0; j < S; j++) regs[j] = _mm256_loadu_si256((const __m256i*)(input+record*S+j*32));
+                deinterleave256<S>(regs);
+                for (size_t s = 0; s < S; s++) _mm256_storeu_si256((__m256i*)(separations[s]+record), regs[s]);
+            }
+            gatherScalar(input, output, size, S, record);
+        }
+
+        template <size_t S>
+        __attribute__((target("avx2")))
+        void scatter_AVX2(const Unit* input, Unit* output, const size_t size) {
+            static_assert(isPowerOfTwo(S));
+            constexpr size_t width = 32;
+            const Unit* separations[S];
+            for (size_t s = 0; s < S; s++) separations[s] = input+separationStart(s, S, size);
+
+            const size_t records = size/S;
+            size_t record = 0;
+            for (; record+width <= records; record += width) {
+                __m256i regs[S];
+                for (size_t s = 0; s < S; s++) regs[s] = _mm256_loadu_si256((const __m256i*)(separations[s]+record));
+                interleave256<S>(regs);
+                for (size_t j = 0; j < S; j++) _mm256_storeu_si256((__m256i*)(output+record*S+j*32), regs[j]);
+            }
+            scatterScalar(input, output, size, S, record);
+        }
+
+        using StrideKernel = void(*)(const Unit*, Unit*, size_t);
+
+        //returns nullptr when the stride has no vector kernel
+        StrideKernel getVectorKernel(const size_t stride, const SIMDLevel level, const bool isGather) {
+            if (level == SIMDLevel::Scalar) return nullptr;
+            const bool useAVX2 = level == SIMDLevel::AVX2;
+            switch (stride) {
+                case 2: return isGather ? (useAVX2 ? gather_AVX2<2> : gather_SSE4<2>) : (useAVX2 ? scatter_AVX2<2> : scatter_SSE4<2>);
+                case 3: return isGather ? gather_SSE4<3> : scatter_SSE4<3>;
+                case 4: return isGather ? (useAVX2 ? gather_AVX2<4> : gather_SSE4<4>) : (useAVX2 ? scatter_AVX2<4> : scatter_SSE4<4>);
+                case 8: return isGather ? (useAVX2 ? gather_AVX2<8> : gather_SSE4<8>) : (useAVX2 ? scatter_AVX2<8> : scatter_SSE4<8>);
+                case 16: return isGather ? (useAVX2 ? gather_AVX2<16> : gather_SSE4<16>) : (useAVX2 ? scatter_AVX2<16> : scatter_SSE4<16>);
+                default: return nullptr;
+            }
+        }
+#endif
+    }
+
+    void strideGather(const Unit* input, Unit* output, const size_t size, const size_t stride, const SIMDLevel level) {
+#if GC_X86_KERNELS
+        if (const auto kernel = getVectorKernel(stride, level, true)) {
+            kernel(input, output, size);
+            return;
+        }
+#endif
+        gatherScalar(input, output, size, stride, 0);
+    }
+
+    void strideScatter(const Unit* input, Unit* output, const size_t size, const size_t stride, const SIMDLevel level) {
+#if GC_X86_KERNELS
+        if (const auto kernel = getVectorKernel(stride, level, false)) {
+            kernel(input, output, size);
+            return;
+        }
+#endif
+        scatterScalar(input, output, size, stride, 0);
+    }
+
+    void strideGather(const Unit* input, Unit* output, const size_t size, const size_t stride) {
+        static const SIMDLevel best = getBestSIMDLevel();
+        strideGather(input, output, size, stride, best);
+    }
+
+    void strideScatter(const Unit* input, Unit* output, const size_t size, const size_t stride) {
+        static const SIMDLevel best = getBestSIMDLevel();
+        strideScatter(input, output, size, stride, best);
+    }
+
+} // GC
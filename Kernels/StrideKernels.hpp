@@ -0,0 +1,31 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_STRIDEKERNELS_HPP
+#define EVOCOM_STRIDEKERNELS_HPP
+
+#include <cstddef>
+#include "../names.hpp"
+#include "SIMDSupport.hpp"
+
+namespace GC {
+
+    /**
+     * The kernels used by StrideTransform.
+     * Gathering splits the input into $stride separations, where separation s holds the units at s, s+stride, s+2*stride...
+     * and the separations are written one after the other. Scattering is the inverse.
+     * When the size is not a multiple of the stride, the first (size % stride) separations have one more unit.
+     *
+     * Strides 2, 3, 4, 8 and 16 have vector kernels specialised at compile time, any other stride uses a direct scalar loop.
+     * input and output must not overlap.
+     */
+    void strideGather(const Unit* input, Unit* output, const size_t size, const size_t stride, const SIMDLevel level);
+    void strideScatter(const Unit* input, Unit* output, const size_t size, const size_t stride, const SIMDLevel level);
+
+    void strideGather(const Unit* input, Unit* output, const size_t size, const size_t stride);
+    void strideScatter(const Unit* input, Unit* output, const size_t size, const size_t stride);
+
+} // GC
+
+#endif //EVOCOM_STRIDEKERNELS_HPP
@@ -8,26 +8,23 @@
 #include <random>
 #include <functional>
 #include "../names.hpp"
+#include "RandomGenerator.hpp"
 
 
 namespace GC {
 
     class RandomDouble {
     private:
-        std::random_device randomDevice;
-        std::mt19937 generator;
         std::uniform_real_distribution<double> distribution;
 
     public:
         RandomDouble(double min, double max):
-                randomDevice(),
-                generator(randomDevice()),
                 distribution(min, max){
 
         }
 
         double choose() {
-            return distribution(randomDevice);
+            return distribution(RandomGenerator::forThisThread());
         }
 
         double operator()() {
@@ -0,0 +1,20 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "RandomGenerator.hpp"
+#include <random>
+
+namespace GC {
+
+    RandomGenerator::Seed RandomGenerator::getFreshSeed() {
+        std::random_device randomDevice;
+        return (Seed(randomDevice()) << 32) ^ randomDevice();
+    }
+
+    RandomGenerator& RandomGenerator::forThisThread() {
+        thread_local RandomGenerator generator(getFreshSeed());
+        return generator;
+    }
+
+} // GC
@@ -0,0 +1,82 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_RANDOMGENERATOR_HPP
+#define EVOCOM_RANDOMGENERATOR_HPP
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace GC {
+
+    /**
+     * xoshiro256**, a small and fast generator which can be used with the std distributions.
+     * Every thread has its own (forThisThread), which the Random* classes draw from:
+     * it starts from a fresh seed, and the evolver reseeds it with the seed of the segment it's working on,
+     * so that a run with a given seed is reproducible.
+     */
+    class RandomGenerator {
+    public:
+        using result_type = uint64_t;
+        using Seed = uint64_t;
+
+    private:
+        std::array<uint64_t, 4> state;
+
+        static uint64_t rotateLeft(const uint64_t x, const int k) {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        static uint64_t splitMix(uint64_t& x) {
+            uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+    public:
+        explicit RandomGenerator(const Seed seed) {
+            reseed(seed);
+        }
+
+        void reseed(Seed seed) {
+            for (uint64_t& word: state) word = splitMix(seed); //never all zeros
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        result_type operator()() {
+            const uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+            const uint64_t t = state[1] << 17;
+            state[2] ^= state[0];
+            state[3] ^= state[1];
+            state[1] ^= state[2];
+            state[0] ^= state[3];
+            state[2] ^= t;
+            state[3] = rotateLeft(state[3], 45);
+            return result;
+        }
+
+        /**
+         * @return a seed for the index-th part of a job seeded with base (eg. the segments of a file), unrelated to the others
+         */
+        static Seed deriveSeed(Seed base, const uint64_t index) {
+            base ^= splitMix(base) + index;
+            return splitMix(base);
+        }
+
+        static Seed getFreshSeed();
+
+        static RandomGenerator& forThisThread();
+
+        static void seedThisThread(const Seed seed) {
+            forThisThread().reseed(seed);
+        }
+    };
+
+} // GC
+
+#endif //EVOCOM_RANDOMGENERATOR_HPP
@@ -5,26 +5,21 @@
 #ifndef DISS_SIMPLEPROTOTYPE_RANDOMINT_HPP
 #define DISS_SIMPLEPROTOTYPE_RANDOMINT_HPP
 #include <random>
+#include "RandomGenerator.hpp"
 
 namespace GC {
 
     template <class I>
     class RandomInt {
     private:
-        std::random_device rd;
-        std::mt19937 gen;
         std::uniform_int_distribution<I> distr;
 
     public:
         RandomInt(const I min, const I max) :
-            rd(),
-            gen(rd()),
             distr(min, max){
         }
 
-        RandomInt() {
-            RandomInt(0, 1);
-        }
+        RandomInt() : RandomInt(0, 1) {}
 
         //mutates it
         I chooseInRange(const I min, const I max) {
@@ -33,7 +28,7 @@ namespace GC {
         }
 
         I choose() {
-            return distr(gen);
+            return distr(RandomGenerator::forThisThread());
         }
 
         I operator()(){
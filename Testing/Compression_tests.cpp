@@ -1,5 +1,6 @@
 #include <catch2/catch.hpp>
 #include "../EvolutionaryFileCompressor/EvolutionaryFileCompressor.hpp"
+#include "../EvolutionaryFileCompressor/RecipePipeline.hpp"
 #include "../AbstractBit/VectorBitWriter/VectorBitWriter.hpp"
 #include "../AbstractBit/VectorBitReader/VectorBitReader.hpp"
 
@@ -79,4 +80,187 @@ namespace GC {
             TEST_ALL_COMPRESSIONS(almostRandomBlock);
         }
     }
-}}
\ No newline at end of file
+}
+
+    /**
+     * Writes the segments as a .gac file would contain them.
+     * When asLegacy is true there is no header and the codes take 4 bits each, as in the files written before format version 1
+     */
+    std::vector<bool> writeSegments(const std::vector<std::pair<Recipe, Block>>& segments, const bool asLegacy) {
+        VectorBitWriter writer;
+        if (!asLegacy) EvolutionaryFileCompressor::writeFileHeader(writer);
+        EvolutionaryFileCompressor::RecipeTable recipeTable;
+        bool isFirstSegment = true;
+        for (const auto& [recipe, block] : segments) {
+            if (!isFirstSegment) writer.pushBit(true);
+            isFirstSegment = false;
+            if (asLegacy) {
+                writer.writeAmountOfBits(recipe.tList.size(), 4);
+                for (const TCode tCode : recipe.tList) writer.writeAmountOfBits(tCode, 4);
+                writer.writeAmountOfBits(recipe.cCode, 4);
+            }
+            else
+                EvolutionaryFileCompressor::encodeRecipeReference(recipe, recipeTable, writer);
+            EvolutionaryFileCompressor::compressBlockUsingRecipe(recipe, block, writer);
+        }
+        writer.pushBit(false);
+        writer.writeLastByte();
+        return writer.getVectorOfBits();
+    }
+
+    Block readSegments(const std::vector<bool>& bits) {
+        VectorBitReader reader(bits);
+        VectorBitWriter writer;
+        EvolutionaryFileCompressor::decompressFromStreams(reader, writer);
+        return writer.getVectorOfBytes();
+    }
+
+    TEST_CASE("File format", "[Compressions]") {
+        Block first, second;
+        for (size_t i=0;i<300;i++) {
+            first.push_back((i*i) % 256);
+            second.push_back(i/7);
+        }
+        Block both = first;
+        both.insert(both.end(), second.begin(), second.end());
+
+        SECTION("Every transform code survives the recipe encoding") {
+            for (const TCode tCode : availableTCodes) {
+                const Recipe recipe({tCode, T_IdentityTransform, tCode}, C_LZWCompression);
+                VectorBitWriter writer;
+                EvolutionaryFileCompressor::encodeIndividual(recipe, writer);
+                VectorBitReader reader(writer.getVectorOfBits());
+                const std::optional<Recipe> decoded = EvolutionaryFileCompressor::decodeIndividual(reader, EvolutionaryFileCompressor::currentFormatVersion);
+                REQUIRE(decoded);
+                CHECK(decoded->tList == recipe.tList);
+                CHECK(decoded->cCode == recipe.cCode);
+            }
+        }
+
+        SECTION("Files in the current format are decoded") {
+            const std::vector<std::pair<Recipe, Block>> segments = {
+                    {Recipe({T_StrideTransform_16, T_DeltaTransform_32, T_StackTransform}, C_HuffmanCompression), first},
+                    {Recipe({T_DeltaXORTransform_64, T_StrideTransform_12}, C_RunLengthCompression), second}};
+            CHECK(readSegments(writeSegments(segments, false)) == both);
+        }
+
+        SECTION("Repeated recipes are referenced through the recipe table") {
+            const Recipe recipeA({T_DeltaTransform, T_StackTransform}, C_HuffmanCompression);
+            const Recipe recipeB({T_StrideTransform_16}, C_LZWCompression);
+            const Recipe recipeC({}, C_IdentityCompression);
+            const std::vector<Recipe> sequence = {recipeA, recipeA, recipeB, recipeA, recipeC, recipeB, recipeB, recipeC};
+
+            std::vector<std::pair<Recipe, Block>> segments;
+            Block expected;
+            for (size_t i=0;i<sequence.size();i++) {
+                const Block& block = (i%2 == 0) ? first : second;
+                segments.emplace_back(sequence[i], block);
+                expected.insert(expected.end(), block.begin(), block.end());
+            }
+            CHECK(readSegments(writeSegments(segments, false)) == expected);
+
+            EvolutionaryFileCompressor::RecipeTable table;
+            VectorBitWriter writer;
+            EvolutionaryFileCompressor::encodeRecipeReference(recipeA, table, writer);
+            const size_t bitsBefore = writer.getVectorOfBits().size();
+            EvolutionaryFileCompressor::encodeRecipeReference(recipeA, table, writer);
+            CHECK(writer.getVectorOfBits().size() == bitsBefore+1);
+            CHECK(table.recipes.size() == 1);
+
+            VectorBitWriter recipeBWriter;
+            EvolutionaryFileCompressor::encodeIndividual(recipeB, recipeBWriter);
+            const size_t bitsBeforeB = writer.getVectorOfBits().size();
+            EvolutionaryFileCompressor::encodeRecipeReference(recipeB, table, writer);
+            CHECK(writer.getVectorOfBits().size() == bitsBeforeB+1+recipeBWriter.getVectorOfBits().size()); //with a single recipe in the table, it can only be new
+        }
+
+        SECTION("Files written before format version 1 are still decoded") {
+            const std::vector<std::pair<Recipe, Block>> segments = {
+                    {Recipe({T_StrideTransform_4, T_DeltaTransform, T_StackTransform, T_SplitTransform, T_SubtractAverageTransform, T_DeltaXORTransform}, C_HuffmanCompression), first},
+                    {Recipe({T_BlockSortingTransform}, C_LZWCompression), second}};
+            CHECK(readSegments(writeSegments(segments, true)) == both);
+        }
+
+        SECTION("Recipes with more than 10 transforms are decoded") {
+            Recipe::TList twelve, fourteen;
+            repeat(6, [&](){twelve.push_back(T_DeltaTransform); twelve.push_back(T_StackTransform);});
+            repeat(14, [&](){fourteen.push_back(T_SplitTransform);});
+            const std::vector<std::pair<Recipe, Block>> segments = {
+                    {Recipe(twelve, C_HuffmanCompression), first},
+                    {Recipe(fourteen, C_LZWCompression), second}};
+            CHECK(readSegments(writeSegments(segments, true)) == both);
+            CHECK(readSegments(writeSegments(segments, false)) == both);
+        }
+
+        SECTION("A legacy recipe with more transforms than supported stops the decompression") {
+            const Recipe recipe({T_DeltaTransform}, C_HuffmanCompression);
+            VectorBitWriter writer;
+            writer.writeAmountOfBits(1, 4);
+            writer.writeAmountOfBits(T_DeltaTransform, 4);
+            writer.writeAmountOfBits(C_HuffmanCompression, 4);
+            EvolutionaryFileCompressor::compressBlockUsingRecipe(recipe, first, writer);
+            writer.pushBit(true); //another segment, whose recipe claims 15 transforms
+            writer.writeAmountOfBits(15, 4);
+            writer.writeAmountOfBits(0, 64);
+            CHECK(readSegments(writer.getVectorOfBits()) == first);
+        }
+
+        SECTION("A parameterised transform with an unknown parameter fails the decoding") {
+            VectorBitWriter writer;
+            writer.writeAmountOfBits(1, 4);
+            writer.writeAmountOfBits(T_DeltaTransform, 4);
+            writer.writeSmallAmount(3); //there's no delta on lanes of 3 units
+            writer.writeAmountOfBits(C_HuffmanCompression, 4);
+            VectorBitReader reader(writer.getVectorOfBits());
+            CHECK_FALSE(EvolutionaryFileCompressor::decodeIndividual(reader, EvolutionaryFileCompressor::currentFormatVersion));
+        }
+    }
+
+    //the bits written by the generic dispatch, without going through the registry
+    std::vector<bool> compressGenerically(const Recipe& recipe, const Block& block) {
+        Block transformed = block;
+        for (const TCode tCode : recipe.tList)
+            EvolutionaryFileCompressor::applyTransformCode(tCode, transformed);
+        VectorBitWriter writer;
+        EvolutionaryFileCompressor::applyCompressionCode(recipe.cCode, transformed, writer);
+        return writer.getVectorOfBits();
+    }
+
+    template <CCode cCode, TCode... tCodes>
+    void checkPipelineMatchesDispatch(const Block& block) {
+        using Pipeline = RecipePipeline<cCode, tCodes...>;
+        EvolutionaryFileCompressor::TransformBuffers buffers;
+        VectorBitWriter writer;
+        Pipeline::compress(block, writer, buffers);
+        const std::vector<bool> bits = writer.getVectorOfBits();
+        CHECK(bits == compressGenerically(Pipeline::getRecipe(), block));
+
+        VectorBitReader reader(bits);
+        CHECK(Pipeline::decompress(reader) == block);
+    }
+
+    TEST_CASE("Recipe pipelines", "[Compressions]") {
+        Block block;
+        for (size_t i=0;i<5000;i++)
+            block.push_back((i%7 == 0) ? (i*31)%256 : (i/13)%256);
+
+        SECTION("Pipelines write the same bits as the generic dispatch") {
+            checkPipelineMatchesDispatch<C_HuffmanCompression, T_DeltaTransform>(block);
+            checkPipelineMatchesDispatch<C_HuffmanCompression, T_StrideTransform_4, T_DeltaTransform>(block);
+            checkPipelineMatchesDispatch<C_HuffmanCompression, T_BurrowsWheelerTransform, T_StackTransform>(block);
+            checkPipelineMatchesDispatch<C_HuffmanCompression, T_DeltaTransform, T_StackTransform>(block);
+            checkPipelineMatchesDispatch<C_LZWCompression, T_StackTransform, T_DeltaXORTransform, T_IdentityTransform, T_StrideTransform_3, T_DeltaTransform, T_StackTransform>(block);
+            checkPipelineMatchesDispatch<C_RunLengthCompression>(block);
+        }
+
+        SECTION("Registered recipes are routed to their pipelines") {
+            const Recipe registered({T_StrideTransform_4, T_DeltaTransform}, C_HuffmanCompression);
+            CHECK(findSpecialisedPipeline(registered) != nullptr);
+            CHECK(findSpecialisedPipeline(Recipe({T_StrideTransform_4, T_DeltaTransform}, C_LZWCompression)) == nullptr);
+
+            VectorBitWriter writer;
+            EvolutionaryFileCompressor::compressBlockUsingRecipe(registered, block, writer);
+            CHECK(writer.getVectorOfBits() == compressGenerically(registered, block));
+        }
+    }
+}
@@ -0,0 +1,261 @@
+#include <catch2/catch.hpp>
+#include "../EvolutionaryFileCompressor/EvolutionaryFileCompressor.hpp"
+#include <cstdio>
+#include <fstream>
+
+namespace GC {
+
+    TEST_CASE("Recipe cache", "[EvolutionaryFileCompressor]") {
+        const std::string cacheFile = "recipe_cache_test.bin";
+        std::remove(cacheFile.c_str());
+
+        Block sample;
+        for (size_t i=0;i<1024;i++) sample.push_back((i*i/7)%256);
+        Block otherSample = sample;
+        otherSample[500]++;
+
+        Evolver::EvolutionSettings settings;
+        Recipe recipe({T_StrideTransform_4, T_DeltaTransform}, C_HuffmanCompression);
+        recipe.getPseudoFitness().setFitnessScore(0.25);
+        recipe.getPseudoFitness().setReliability(1.0);
+
+        SECTION("The key depends on the sample and on the settings, but not on the seed") {
+            const RecipeCache::Key key = RecipeCache::makeKey(sample, settings);
+            CHECK(key == RecipeCache::makeKey(sample, settings));
+            CHECK(!(key == RecipeCache::makeKey(otherSample, settings)));
+
+            Evolver::EvolutionSettings seeded = settings;
+            seeded.seed = 5;
+            CHECK(key == RecipeCache::makeKey(sample, seeded));
+
+            Evolver::EvolutionSettings longer = settings;
+            longer.generationCount++;
+            CHECK(!(key == RecipeCache::makeKey(sample, longer)));
+
+            const SurrogateModel model, retrained(SurrogateModel::Weights(SurrogateModel::weightAmount, 0.5));
+            CHECK(!(key == RecipeCache::makeKey(sample, settings, &model)));
+            CHECK(!(RecipeCache::makeKey(sample, settings, &model) == RecipeCache::makeKey(sample, settings, &retrained)));
+            CHECK(!(key == RecipeCache::makeKey(sample, settings, nullptr, true)));
+        }
+
+        SECTION("Recipes persist across instances") {
+            const RecipeCache::Key key = RecipeCache::makeKey(sample, settings);
+            {
+                RecipeCache cache(cacheFile);
+                CHECK(!cache.find(key).has_value());
+                cache.store(key, recipe);
+            } //saved here
+
+            RecipeCache reopened(cacheFile);
+            const std::optional<Recipe> found = reopened.find(key);
+            REQUIRE(found.has_value());
+            CHECK(*found == recipe);
+            CHECK(found->getFitness() == 0.25);
+            CHECK(found->isFitnessAssessed());
+            CHECK(!reopened.find(RecipeCache::makeKey(otherSample, settings)).has_value());
+        }
+
+        SECTION("A hit alone doesn't rewrite the file") {
+            const RecipeCache::Key key = RecipeCache::makeKey(sample, settings);
+            {
+                RecipeCache cache(cacheFile);
+                cache.store(key, recipe);
+            }
+            {
+                RecipeCache reopened(cacheFile);
+                CHECK(reopened.find(key).has_value());
+                std::remove(cacheFile.c_str());
+            } //nothing to save
+            CHECK_FALSE(std::ifstream(cacheFile).good());
+        }
+
+        SECTION("Records with unknown codes are misses") {
+            const RecipeCache::Key key = RecipeCache::makeKey(sample, settings);
+            //the records follow a 32 byte header, and in a 48 byte record the compression code is at 32, the amount of transforms at 33
+            const size_t offsetInRecord = GENERATE(32, 33, 34);
+            const size_t capacity = RecipeCache::probeWindow;
+            {
+                RecipeCache cache(cacheFile, capacity);
+                cache.store(key, recipe);
+            }
+            {
+                std::fstream file(cacheFile, std::ios::binary | std::ios::in | std::ios::out);
+                for (size_t i=0;i<capacity;i++) {
+                    file.seekp(32+48*i+offsetInRecord);
+                    file.put(static_cast<char>(255));
+                }
+            }
+            {
+                RecipeCache damaged(cacheFile, capacity);
+                CHECK_FALSE(damaged.find(key).has_value());
+                CHECK(damaged.getStatistics().misses == 1);
+            } //saved without the record
+            RecipeCache reopened(cacheFile, capacity);
+            CHECK_FALSE(reopened.find(key).has_value());
+        }
+
+        SECTION("The cache is bounded") {
+            RecipeCache cache(cacheFile, 16);
+            for (size_t i=0;i<100;i++) {
+                Block different = sample;
+                different[0] = i;
+                cache.store(RecipeCache::makeKey(different, settings), recipe);
+            }
+            CHECK(cache.getCapacity() == 16);
+            CHECK(cache.getStatistics().evictions >= 100-16);
+        }
+
+        SECTION("An unchanged segment is not evolved again") {
+            settings.populationSize = 12;
+            settings.generationCount = 4;
+            RecipeCache cache(cacheFile);
+            Evaluator::CacheStatistics firstStatistics, secondStatistics;
+            const Recipe first = EvolutionaryFileCompressor::evolveBestIndividualForBlock(sample, settings, firstStatistics, &cache);
+            const Recipe second = EvolutionaryFileCompressor::evolveBestIndividualForBlock(sample, settings, secondStatistics, &cache);
+            CHECK(firstStatistics.misses > 0);
+            CHECK(secondStatistics.getRequests() == 0);
+            CHECK(second == first);
+            CHECK(second.getFitness() == first.getFitness());
+        }
+
+        std::remove(cacheFile.c_str());
+    }
+
+    TEST_CASE("Effort scheduler", "[EvolutionaryFileCompressor]") {
+        Block compressible(4096, 7);
+        for (size_t i=0;i<compressible.size();i+=16) compressible[i] = i/16;
+        Block noisy;
+        for (size_t i=0;i<4096;i++) noisy.push_back((i*2654435761u)>>13);
+        CHECK(EffortScheduler::getHeadroom(compressible) > EffortScheduler::getHeadroom(noisy));
+
+        SECTION("Without a budget nothing is allocated") {
+            EffortScheduler scheduler(8192, 0, EffortScheduler::Milliseconds(0));
+            CHECK(!scheduler.isEnabled());
+            Evolver::EvolutionSettings settings;
+            scheduler.allocate(compressible).applyTo(settings);
+            CHECK(settings.evaluationBudget == 0);
+            CHECK(!settings.timeBudget.has_value());
+        }
+
+        SECTION("More compressible segments get more, and the budget is never exceeded") {
+            EffortScheduler scheduler(3*4096, 3000, EffortScheduler::Milliseconds(0));
+            const auto first = scheduler.allocate(noisy);
+            const auto second = scheduler.allocate(compressible);
+            const auto third = scheduler.allocate(noisy);
+            CHECK(second.evaluations > first.evaluations);
+            CHECK(first.evaluations + second.evaluations + third.evaluations <= 3000);
+            CHECK(scheduler.getRemainingEvaluations() == 3000 - first.evaluations - second.evaluations - third.evaluations);
+        }
+
+        SECTION("What a segment doesn't use goes to the next ones") {
+            EffortScheduler withLeftovers(2*4096, 1000, EffortScheduler::Milliseconds(0));
+            EffortScheduler withoutLeftovers(2*4096, 1000, EffortScheduler::Milliseconds(0));
+            const auto first = withLeftovers.allocate(compressible);
+            withLeftovers.registerUsage(first, first.evaluations/4, EffortScheduler::Milliseconds(0));
+            const auto firstToo = withoutLeftovers.allocate(compressible);
+            withoutLeftovers.registerUsage(firstToo, firstToo.evaluations, EffortScheduler::Milliseconds(0));
+            CHECK(withLeftovers.allocate(compressible).evaluations > withoutLeftovers.allocate(compressible).evaluations);
+        }
+    }
+
+    TEST_CASE("Warm start board", "[EvolutionaryFileCompressor]") {
+        Block text, noise;
+        RandomGenerator::seedThisThread(11);
+        RandomInt<size_t> randomByte(0, 255);
+        for (size_t i=0;i<2048;i++) {
+            text.push_back("the quick brown fox "[i % 20]);
+            noise.push_back(randomByte.choose());
+        }
+
+        SECTION("The board hints the elite of the most similar segment") {
+            WarmStartBoard board;
+            CHECK(board.findHint(text).empty());
+            const Recipe forText({T_DeltaTransform}, C_HuffmanCompression);
+            const Recipe forNoise({}, C_IdentityCompression);
+            board.publish(text, {forText});
+            board.publish(noise, {forNoise});
+            CHECK(board.findHint(Block(text.begin(), text.begin()+1000)) == std::vector<Recipe>{forText});
+            CHECK(board.findHint(Block(noise.begin()+500, noise.end())) == std::vector<Recipe>{forNoise});
+
+            const Recipe laterForText({T_StackTransform}, C_HuffmanCompression);
+            board.publish(text, {laterForText});
+            CHECK(board.findHint(text) == std::vector<Recipe>{laterForText}); //ties go to the latest
+
+            repeat(2*WarmStartBoard::maxEntries, [&](){board.publish(noise, {forNoise});});
+            CHECK(board.size() == WarmStartBoard::maxEntries);
+        }
+
+        SECTION("The segments of a file share the board") {
+            Evolver::EvolutionSettings settings;
+            settings.generationCount = 6;
+            settings.populationSize = 12;
+            settings.seed = 5;
+            WarmStartBoard board;
+            EvolutionaryFileCompressor::evolveBestIndividualForBlock(text, settings, nullptr, &board);
+            EvolutionaryFileCompressor::evolveBestIndividualForBlock(text, settings, nullptr, &board);
+            CHECK(board.size() == 2);
+            CHECK_FALSE(board.findHint(text).empty());
+        }
+    }
+
+    TEST_CASE("Surrogate model", "[EvolutionaryFileCompressor]") {
+        RandomGenerator::seedThisThread(17);
+        RandomInt<size_t> randomTCode(0, SurrogateModel::tCodeAmount-1);
+        RandomInt<size_t> randomCCode(0, SurrogateModel::cCodeAmount-1);
+        RandomInt<size_t> randomLength(0, Recipe::maxTransformAmount_STATIC);
+        auto randomRecipe = [&]() {
+            Recipe::TList tList;
+            repeat(randomLength.choose(), [&](){tList.push_back(static_cast<TCode>(randomTCode.choose()));});
+            return Recipe(tList, static_cast<CCode>(randomCCode.choose()));
+        };
+
+        SECTION("The trainer recovers a linear fitness") {
+            SurrogateModel::Weights trueWeights(SurrogateModel::weightAmount);
+            for (size_t i=0;i<trueWeights.size();i++) trueWeights[i] = (double)(i%7)/10 - 0.3;
+            const SurrogateModel truth(trueWeights);
+
+            std::vector<SurrogateModel::Features> samples;
+            for (const size_t period: {1, 3, 16, 200}) {
+                Block block;
+                for (size_t i=0;i<512;i++) block.push_back((i*i/period)%256);
+                samples.push_back(SurrogateModel::getFeatures(block));
+            }
+
+            SurrogateModel::Trainer trainer;
+            repeat(3000, [&](){
+                const auto& features = samples[randomTCode.choose() % samples.size()];
+                const Recipe recipe = randomRecipe();
+                trainer.addSample(features, recipe, truth.predict(features, recipe));
+            });
+            CHECK(trainer.getSampleAmount() == 3000);
+
+            const SurrogateModel fitted = trainer.fit(1e-9);
+            repeat(100, [&](){
+                const Recipe recipe = randomRecipe();
+                for (const auto& features: samples)
+                    CHECK(fitted.predict(features, recipe) == Approx(truth.predict(features, recipe)).margin(1e-4));
+            });
+        }
+
+        SECTION("Models are saved and loaded") {
+            const std::string modelFile = "surrogate_test.txt";
+            SurrogateModel::Weights weights(SurrogateModel::weightAmount);
+            for (size_t i=0;i<weights.size();i++) weights[i] = 1.0/(i+3);
+            const SurrogateModel model(weights);
+            REQUIRE(model.save(modelFile));
+
+            const std::optional<SurrogateModel> loaded = SurrogateModel::load(modelFile);
+            REQUIRE(loaded.has_value());
+            const SurrogateModel::Features features = SurrogateModel::getFeatures({1, 2, 3, 3, 3, 200});
+            repeat(20, [&](){
+                const Recipe recipe = randomRecipe();
+                CHECK(loaded->predict(features, recipe) == model.predict(features, recipe));
+            });
+
+            std::ofstream(modelFile) << "EVOCOM_SURROGATE 1 2 3\n";
+            CHECK_FALSE(SurrogateModel::load(modelFile).has_value());
+            CHECK_FALSE(SurrogateModel::load("does_not_exist.txt").has_value());
+            std::remove(modelFile.c_str());
+        }
+    }
+}
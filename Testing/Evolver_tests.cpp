@@ -0,0 +1,695 @@
+#include <catch2/catch.hpp>
+#include "../Evolver/Evolver.hpp"
+#include "../EvolutionaryFileCompressor/EvolutionaryFileCompressor.hpp"
+#include "../AbstractBit/VectorBitWriter/VectorBitWriter.hpp"
+#include "../AbstractBit/VectorBitReader/VectorBitReader.hpp"
+#include <thread>
+#include <unordered_set>
+#include <atomic>
+#include <numeric>
+
+namespace GC {
+
+    //a deterministic fitness which prefers short recipes that use the Huffman compression
+    Evaluator::FitnessScore toyFitness(const Recipe& recipe) {
+        return 0.5 + 0.1*recipe.getTListLength() + ((recipe.cCode == C_HuffmanCompression) ? 0.0 : 0.3);
+    }
+
+    namespace {
+        //a fitness whose best recipe is known in advance: the distance from the target (0.5 when it's reached)
+        Evaluator::FitnessFunction distanceTo(const Recipe& target) {
+            return [target](const Recipe& recipe) -> Evaluator::FitnessScore {
+                return 0.5 + recipe.distanceFrom(target);
+            };
+        }
+    }
+
+    TEST_CASE("Fitness cache", "[Evolver]") {
+        std::vector<Recipe> evaluated;
+        auto countingFitness = [&](const Recipe& recipe) {
+            evaluated.push_back(recipe);
+            return toyFitness(recipe);
+        };
+
+        SECTION("Identical recipes are only evaluated once") {
+            Evaluator evaluator(countingFitness);
+            Recipe first({T_DeltaTransform, T_StackTransform}, C_HuffmanCompression);
+            Recipe second({T_DeltaTransform, T_StackTransform}, C_HuffmanCompression);
+            Recipe other({T_StackTransform}, C_HuffmanCompression);
+
+            evaluator.forceEvaluation(first);
+            evaluator.forceEvaluation(second);
+            evaluator.forceEvaluation(other);
+            CHECK(evaluated.size() == 2);
+            CHECK(second.isFitnessAssessed());
+            CHECK(second.getFitness() == first.getFitness());
+
+            evaluator.forceEvaluation(first); //already actual, so it's not even looked up
+            const Evaluator::CacheStatistics& statistics = evaluator.getCacheStatistics();
+            CHECK(statistics.misses == 2);
+            CHECK(statistics.hits == 1);
+            CHECK(statistics.skipped == 1);
+            CHECK(statistics.getHitRate() == Approx(0.5));
+        }
+
+        SECTION("An evolver never evaluates the same recipe twice") {
+            Evolver::EvolutionSettings settings;
+            settings.populationSize = 20;
+            settings.generationCount = 15;
+            Evolver evolver(settings, countingFitness);
+            const Recipe best = evolver.evolveBest();
+
+            std::unordered_set<Recipe> distinct(evaluated.begin(), evaluated.end());
+            CHECK(distinct.size() == evaluated.size());
+            CHECK(evolver.getFitnessCacheStatistics().misses == evaluated.size());
+            CHECK(evolver.getFitnessCacheStatistics().getRequests() > evaluated.size());
+            CHECK(best.getFitness() == Approx(toyFitness(best)));
+        }
+    }
+
+    TEST_CASE("Parallel evaluation", "[Evolver]") {
+        SECTION("The thread pool runs every index exactly once") {
+            ThreadPool pool(4);
+            CHECK(pool.getThreadAmount() == 4);
+            for (const size_t amount : {0, 1, 3, 100, 1000}) {
+                std::vector<std::atomic<int>> runs(amount);
+                pool.forEachIndex(amount, [&](const size_t i){runs[i]++;});
+                CHECK(std::all_of(runs.begin(), runs.end(), [](const std::atomic<int>& r){return r == 1;}));
+            }
+        }
+
+        SECTION("A batch evaluated by several threads matches the serial evaluation") {
+            std::vector<Recipe> recipes;
+            Breeder breeder(0.1, 0.3, 0, 6);
+            Breeder::RandomIndividual randomIndividualMaker(breeder);
+            repeat(200, [&](){recipes.push_back(randomIndividualMaker.makeIndividual());});
+            recipes.push_back(recipes[3]); //repeats within the batch
+            recipes.push_back(recipes[7]);
+
+            std::atomic<size_t> parallelCalls{0};
+            auto parallelFitness = [&](const Recipe& recipe){
+                parallelCalls++;
+                return toyFitness(recipe);
+            };
+
+            std::vector<Recipe> serialRecipes = recipes;
+            Evaluator serial(toyFitness);
+            serial.keepEvaluationLog();
+            for (Recipe& recipe: serialRecipes) serial.forceEvaluation(recipe);
+
+            Evaluator parallel(parallelFitness, 8);
+            parallel.keepEvaluationLog();
+            CHECK(parallel.getEvaluationThreads() == 8);
+            parallel.forceEvaluations(recipes);
+
+            for (size_t i=0;i<recipes.size();i++) {
+                CHECK(recipes[i].isFitnessAssessed());
+                CHECK(recipes[i].getFitness() == serialRecipes[i].getFitness());
+            }
+            CHECK(parallelCalls == parallel.getCacheStatistics().misses);
+            CHECK(parallel.getCacheStatistics().misses == serial.getCacheStatistics().misses);
+            CHECK(parallel.getCacheStatistics().hits == serial.getCacheStatistics().hits);
+            CHECK(parallel.getEvaluationLog() == serial.getEvaluationLog()); //in the order of the batch, not of the threads
+        }
+
+        SECTION("An evolver with several evaluation threads still never evaluates the same recipe twice") {
+            std::mutex evaluatedMutex;
+            std::vector<Recipe> evaluated;
+            auto countingFitness = [&](const Recipe& recipe) {
+                std::lock_guard<std::mutex> lock(evaluatedMutex);
+                evaluated.push_back(recipe);
+                return toyFitness(recipe);
+            };
+
+            Evolver::EvolutionSettings settings;
+            settings.populationSize = 30;
+            settings.generationCount = 15;
+            settings.evaluationThreads = 4;
+            Evolver evolver(settings, countingFitness);
+            const Recipe best = evolver.evolveBest();
+
+            std::unordered_set<Recipe> distinct(evaluated.begin(), evaluated.end());
+            CHECK(distinct.size() == evaluated.size());
+            CHECK(evolver.getFitnessCacheStatistics().misses == evaluated.size());
+            CHECK(best.getFitness() == Approx(toyFitness(best)));
+        }
+    }
+
+    TEST_CASE("Seeded randomness", "[Evolver]") {
+        SECTION("Generators with the same seed give the same numbers") {
+            RandomGenerator a(42), b(42), c(43);
+            bool differsFromC = false;
+            for (size_t i=0;i<100;i++) {
+                const auto fromA = a();
+                CHECK(fromA == b());
+                differsFromC |= (fromA != c());
+            }
+            CHECK(differsFromC);
+            CHECK(RandomGenerator::deriveSeed(42, 0) != RandomGenerator::deriveSeed(42, 1));
+            CHECK(RandomGenerator::deriveSeed(42, 1) == RandomGenerator::deriveSeed(42, 1));
+        }
+
+        SECTION("Reseeding the thread repeats the draws of the Random classes") {
+            auto draw = [&]() {
+                RandomInt<size_t> randomInt(0, 1000);
+                RandomChance randomChance(0.5);
+                std::vector<size_t> draws;
+                repeat(50, [&](){draws.push_back(randomInt() + 2000*randomChance.choose());});
+                return draws;
+            };
+            RandomGenerator::seedThisThread(7);
+            const auto first = draw();
+            RandomGenerator::seedThisThread(7);
+            CHECK(draw() == first);
+        }
+
+        SECTION("An evolver with a seed is reproducible, whatever the amount of evaluation threads") {
+            auto evolveWith = [&](const size_t threads) {
+                Evolver::EvolutionSettings settings;
+                settings.populationSize = 24;
+                settings.generationCount = 12;
+                settings.evaluationThreads = threads;
+                settings.seed = 1234;
+                Evolver evolver(settings, toyFitness);
+                const Recipe best = evolver.evolveBest();
+                return std::make_pair(best, evolver.getFitnessCacheStatistics().misses);
+            };
+
+            const auto [best, evaluations] = evolveWith(1);
+            for (const size_t threads : {1, 4}) {
+                const auto [otherBest, otherEvaluations] = evolveWith(threads);
+                CHECK(otherBest == best);
+                CHECK(otherEvaluations == evaluations);
+            }
+        }
+    }
+
+    TEST_CASE("Tournament selection", "[Evolver]") {
+        std::vector<Recipe> population;
+        for (size_t i=0;i<20;i++) {
+            Recipe recipe({T_DeltaTransform}, C_HuffmanCompression);
+            recipe.getPseudoFitness().setFitnessScore(1.0 + ((i*7)%20)); //all distinct, the best is at i=0
+            recipe.getPseudoFitness().setReliability(1.0);
+            population.push_back(recipe);
+        }
+
+        SECTION("Selected individuals are references into the population") {
+            Selector selector{Selector::TournamentSelection(0.25)};
+            selector.preparePool(population);
+            CHECK(selector.getTournamentSize() == 5);
+            for (size_t i=0;i<100;i++) {
+                const Recipe& selected = selector.select();
+                CHECK(&selected >= population.data());
+                CHECK(&selected < population.data()+population.size());
+            }
+        }
+
+        SECTION("Larger tournaments prefer fitter individuals") {
+            auto averageSelectedFitness = [&](const Proportion proportion) {
+                Selector selector{Selector::TournamentSelection(proportion)};
+                selector.preparePool(population);
+                double total = 0;
+                for (size_t i=0;i<1000;i++) total += population[selector.selectIndex()].getFitness();
+                return total / 1000;
+            };
+            CHECK(averageSelectedFitness(0.05) > averageSelectedFitness(0.3));
+            CHECK(averageSelectedFitness(0.3) > averageSelectedFitness(2.0));
+        }
+
+        SECTION("The elite are the fittest") {
+            Selector selector{Selector::TournamentSelection(0.25)};
+            std::vector<Recipe> elite = selector.selectElite(3, population);
+            std::vector<double> eliteFitnesses;
+            for (const Recipe& individual: elite) eliteFitnesses.push_back(individual.getFitness());
+            std::sort(eliteFitnesses.begin(), eliteFitnesses.end());
+            CHECK(eliteFitnesses == std::vector<double>{1.0, 2.0, 3.0});
+        }
+    }
+
+    TEST_CASE("Early stopping", "[Evolver]") {
+        Evolver::EvolutionSettings settings;
+        settings.populationSize = 20;
+        settings.generationCount = 500;
+        settings.usesSimulatedAnnealing = false; //otherwise the mutation could become extreme first
+        settings.seed = 99;
+
+        SECTION("Without criteria, all the generations are run") {
+            settings.generationCount = 30;
+            Evolver evolver(settings, toyFitness);
+            evolver.evolveBest();
+            CHECK(evolver.getStopReason() == Evolver::StopReason::Completed);
+            CHECK(evolver.getGenerationsRun() == 30);
+        }
+
+        SECTION("A stagnating evolution stops") {
+            settings.stagnationLimit = 5;
+            Evolver evolver(settings, toyFitness);
+            const Recipe best = evolver.evolveBest();
+            CHECK(evolver.getStopReason() == Evolver::StopReason::Stagnation);
+            CHECK(evolver.getGenerationsRun() < 500);
+            CHECK(best.isFitnessAssessed());
+        }
+
+        SECTION("Reaching the target fitness stops") {
+            settings.targetFitness = 0.65;
+            Evolver evolver(settings, toyFitness);
+            const Recipe best = evolver.evolveBest();
+            CHECK(evolver.getStopReason() == Evolver::StopReason::TargetReached);
+            CHECK(best.getFitness() <= 0.65);
+        }
+
+        SECTION("The time budget is respected, and the best so far is returned") {
+            settings.timeBudget = std::chrono::milliseconds(50);
+            auto slowFitness = [&](const Recipe& recipe) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                return toyFitness(recipe);
+            };
+            const auto start = std::chrono::steady_clock::now();
+            Evolver evolver(settings, slowFitness);
+            const Recipe best = evolver.evolveBest();
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            CHECK(evolver.getStopReason() == Evolver::StopReason::Deadline);
+            CHECK(elapsed < std::chrono::seconds(2));
+            CHECK(best.isFitnessAssessed());
+            CHECK(best.getFitness() == Approx(toyFitness(best)));
+
+            Logger logger;
+            Evolver loggedEvolver(settings, slowFitness);
+            const Recipe loggedBest = loggedEvolver.evolveBestAndLogProgress(logger);
+            CHECK(loggedEvolver.getStopReason() == Evolver::StopReason::Deadline);
+            CHECK(loggedBest == loggedEvolver.finishEvolution()); //the best so far, like evolveBest
+        }
+
+        SECTION("The evolver respects its evaluation budget") {
+            settings.evaluationBudget = 60;
+            Evolver evolver(settings, toyFitness);
+            evolver.evolveBest();
+            CHECK(evolver.getStopReason() == Evolver::StopReason::BudgetExhausted);
+            CHECK(evolver.getFitnessCacheStatistics().misses < 60 + 2*settings.populationSize); //it can only overrun by the last generation (and the final assessment)
+        }
+    }
+
+    TEST_CASE("Packed recipes", "[Evolver]") {
+        STATIC_REQUIRE(std::is_trivially_copyable_v<Recipe>);
+        STATIC_REQUIRE(sizeof(Recipe::TList) == 2*sizeof(uint64_t));
+
+        SECTION("The packed list behaves like a vector") {
+            RandomGenerator::seedThisThread(7);
+            RandomInt<size_t> randomCode(0, T_StrideTransform_16);
+            RandomInt<size_t> randomIndex(0, 100);
+            Recipe::TList packed;
+            std::vector<TCode> expected;
+            for (size_t step=0;step<2000;step++) {
+                const TCode tCode = static_cast<TCode>(randomCode.choose());
+                const size_t size = expected.size();
+                const size_t operation = randomIndex.choose() % 3;
+                if (operation == 0 && size < Recipe::TList::capacity) {
+                    const size_t index = randomIndex.choose() % (size+1);
+                    packed.insert(packed.begin()+index, tCode);
+                    expected.insert(expected.begin()+index, tCode);
+                }
+                else if (operation == 1 && size > 0) {
+                    const size_t index = randomIndex.choose() % size;
+                    packed.erase(packed.begin()+index);
+                    expected.erase(expected.begin()+index);
+                }
+                else if (size > 0) {
+                    const size_t index = randomIndex.choose() % size;
+                    packed.set(index, tCode);
+                    expected[index] = tCode;
+                }
+                REQUIRE(packed.toVector() == expected);
+                REQUIRE(packed == Recipe::TList(expected.begin(), expected.end()));
+            }
+        }
+
+        SECTION("Inserting at the last slot") {
+            std::vector<TCode> expected(Recipe::TList::capacity-1, T_DeltaTransform);
+            Recipe::TList packed(expected.begin(), expected.end());
+            packed.insert(packed.end(), T_StackTransform);
+            expected.push_back(T_StackTransform);
+            CHECK(packed.toVector() == expected);
+        }
+
+        SECTION("Equality and hashing only depend on the codes") {
+            Recipe A({T_DeltaTransform, T_StackTransform}, C_HuffmanCompression);
+            Recipe B({T_DeltaTransform}, C_HuffmanCompression);
+            B.tList.push_back(T_StackTransform);
+            B.getPseudoFitness().setActualFitness(0.5);
+            CHECK(A == B);
+            CHECK(std::hash<Recipe>()(A) == std::hash<Recipe>()(B));
+
+            B.tList.pop_back();
+            B.tList.push_back(T_IdentityTransform); //the identity transform is code 0, like the unused bits
+            CHECK_FALSE(A == B);
+            CHECK_FALSE(Recipe({}, C_HuffmanCompression) == Recipe({T_IdentityTransform}, C_HuffmanCompression));
+            CHECK_FALSE(Recipe({T_StackTransform}, C_HuffmanCompression) == Recipe({T_StackTransform}, C_LZWCompression));
+        }
+
+        SECTION("The distance is the edit distance") {
+            const Recipe A({T_DeltaTransform, T_StackTransform, T_SplitTransform}, C_HuffmanCompression);
+            const Recipe B({T_StackTransform, T_SplitTransform, T_RunLengthTransform, T_DeltaTransform}, C_LZWCompression);
+            CHECK(A.distanceFrom(B) == 3+1); //+1 for the compression
+            CHECK(A.distanceFrom(A) == 0);
+        }
+
+        SECTION("Recipes at full capacity survive the file format") {
+            Recipe::TList full;
+            repeat(Recipe::TList::capacity, [&](){full.push_back(T_StrideTransform_16);});
+            const Recipe recipe(full, C_HuffmanCompression);
+            VectorBitWriter writer;
+            EvolutionaryFileCompressor::encodeIndividual(recipe, writer);
+            VectorBitReader reader(writer.getVectorOfBits());
+            CHECK(EvolutionaryFileCompressor::decodeIndividual(reader, EvolutionaryFileCompressor::currentFormatVersion) == std::optional<Recipe>(recipe));
+        }
+    }
+
+    TEST_CASE("Island model", "[Evolver]") {
+        const Recipe target({T_DeltaTransform, T_StrideTransform_4, T_SplitTransform, T_StackTransform}, C_LZWCompression);
+        const Evaluator::FitnessFunction distanceToTarget = distanceTo(target);
+
+        SECTION("The mailbox delivers the messages in order between two threads") {
+            Mailbox<size_t, 8> mailbox;
+            constexpr size_t amount = 20000;
+            std::thread sender([&](){
+                for (size_t i=0;i<amount;i++)
+                    while (!mailbox.tryPost(i)) std::this_thread::yield();
+            });
+            bool isInOrder = true;
+            for (size_t expected=0;expected<amount;) {
+                if (const auto message = mailbox.tryTake()) {
+                    isInOrder &= (*message == expected);
+                    expected++;
+                }
+                else std::this_thread::yield();
+            }
+            sender.join();
+            CHECK(isInOrder);
+            CHECK_FALSE(mailbox.tryTake());
+        }
+
+        SECTION("Immigrants replace the worst individuals") {
+            Evolver::EvolutionSettings settings;
+            settings.populationSize = 10;
+            settings.seed = 3;
+            Evolver evolver(settings, distanceToTarget);
+            Recipe immigrant = target;
+            immigrant.getPseudoFitness().setActualFitness(0.5);
+            evolver.receiveImmigrants({immigrant});
+            CHECK(evolver.getElite(1).front() == target);
+        }
+
+        Evolver::EvolutionSettings settings;
+        settings.populationSize = 12;
+        settings.generationCount = 30;
+        settings.islandAmount = 4;
+        settings.migrationInterval = 3;
+        settings.migrantAmount = 2;
+        settings.seed = 99;
+
+        SECTION("With a seed, the result doesn't depend on the scheduling of the islands") {
+            auto evolveIslands = [&]() {
+                IslandEvolver islands(settings, distanceToTarget);
+                const Recipe best = islands.evolveBest();
+                return std::make_pair(best, islands.getFitnessCacheStatistics().misses);
+            };
+            const auto [best, evaluations] = evolveIslands();
+            for (size_t run=0;run<3;run++) {
+                const auto [otherBest, otherEvaluations] = evolveIslands();
+                CHECK(otherBest == best);
+                CHECK(otherEvaluations == evaluations);
+            }
+            CHECK(best.isFitnessAssessed());
+        }
+
+        SECTION("Islands which stop early don't block the others") {
+            settings.generationCount = 200;
+            settings.stagnationLimit = 4;
+            IslandEvolver islands(settings, distanceToTarget);
+            islands.evolveBest();
+            CHECK(islands.getFitnessCacheStatistics().misses > 0);
+        }
+
+        SECTION("The islands report every statistic and the elite of the best island") {
+            IslandEvolver screenedIslands(settings, distanceToTarget);
+            screenedIslands.setSurrogate([](const Recipe&){ return 100.0; }); //always clearly worse
+            screenedIslands.evolveBest();
+            CHECK(screenedIslands.getFitnessCacheStatistics().screened > 0);
+
+            IslandEvolver islands(settings, distanceToTarget);
+            islands.setLowFidelityFitnessFunction(distanceToTarget);
+            islands.evolveBest();
+            CHECK(islands.getFitnessCacheStatistics().lowFidelity > 0);
+
+            const Evolver::Population elite = islands.getElite(settings.eliteSize);
+            CHECK_FALSE(elite.empty());
+            CHECK(elite.size() <= settings.eliteSize);
+        }
+
+        SECTION("A single island is an ordinary evolver") {
+            settings.islandAmount = 1;
+            IslandEvolver island(settings, distanceToTarget);
+            const Recipe fromIsland = island.evolveBest();
+            Evolver evolver(settings, distanceToTarget); //reseeds the generator of the thread
+            CHECK(fromIsland == evolver.evolveBest());
+        }
+    }
+
+    TEST_CASE("Warm start", "[Evolver]") {
+        const Recipe target({T_DeltaTransform, T_StrideTransform_4, T_SplitTransform, T_StackTransform}, C_LZWCompression);
+        const Evaluator::FitnessFunction distanceToTarget = distanceTo(target);
+
+        Evolver::EvolutionSettings settings;
+        settings.populationSize = 20;
+        settings.generationCount = 50;
+        settings.seed = 5;
+
+        SECTION("A hint that can't be improved stops the evolution early") {
+            Evolver evolver(settings, distanceToTarget, {target});
+            CHECK(evolver.evolveBest() == target);
+            CHECK(evolver.getStopReason() == Evolver::StopReason::HintConfirmed);
+            CHECK(evolver.getGenerationsRun() == settings.warmStartCheckGeneration);
+        }
+
+        SECTION("The fitness of the hint is assessed again") {
+            Recipe misleading({T_RunLengthTransform}, C_HuffmanCompression);
+            misleading.getPseudoFitness().setActualFitness(0.0);
+            settings.warmStartCheckGeneration = 0;
+            Evolver evolver(settings, distanceToTarget, {misleading});
+            const Recipe best = evolver.evolveBest();
+            CHECK(best.getFitness() == distanceToTarget(best));
+            CHECK(evolver.getStopReason() != Evolver::StopReason::HintConfirmed);
+        }
+
+        SECTION("An empty hint is an ordinary random start") {
+            Evolver hinted(settings, distanceToTarget, {});
+            const Recipe fromHinted = hinted.evolveBest();
+            Evolver plain(settings, distanceToTarget); //reseeds the generator of the thread
+            CHECK(fromHinted == plain.evolveBest());
+        }
+    }
+
+    TEST_CASE("Surrogate screening", "[Evolver]") {
+        SECTION("The evolver never evaluates the children that the surrogate rules out") {
+            const Recipe target({T_DeltaTransform, T_StrideTransform_4, T_SplitTransform}, C_HuffmanCompression);
+            const Evaluator::FitnessFunction distanceToTarget = distanceTo(target);
+            auto surrogate = [&](const Recipe& recipe) { //always clearly worse for the LZW compression, exact otherwise
+                return (recipe.cCode == C_LZWCompression) ? 100.0 : distanceToTarget(recipe);
+            };
+            bool isPopulationInitialised = false; //the initial population is always evaluated
+            size_t lzwEvaluations = 0;
+            auto countingFitness = [&](const Recipe& recipe) {
+                if (isPopulationInitialised && recipe.cCode == C_LZWCompression) lzwEvaluations++;
+                return distanceToTarget(recipe);
+            };
+
+            Evolver::EvolutionSettings settings;
+            settings.populationSize = 30;
+            settings.generationCount = 30;
+            settings.seed = 3;
+            settings.surrogateMargin = 1;
+
+            Evolver evolver(settings, countingFitness);
+            isPopulationInitialised = true;
+            evolver.setSurrogate(surrogate);
+            while (evolver.evolveNextGeneration());
+
+            CHECK(evolver.getFitnessCacheStatistics().screened > 0);
+            CHECK(lzwEvaluations == 0);
+            const Recipe best = evolver.finishEvolution();
+            CHECK(best.getFitness() == distanceToTarget(best)); //the result always has an actual fitness
+        }
+    }
+
+    TEST_CASE("Beam search", "[Evolver]") {
+        const Recipe target({T_DeltaTransform, T_StrideTransform_4}, C_HuffmanCompression);
+        const Evaluator::FitnessFunction distanceToTarget = distanceTo(target);
+
+        Evolver::EvolutionSettings settings;
+        settings.beamWidth = 4;
+        settings.beamDepth = 3;
+        const size_t extensionsPerChain = availableTCodes.size()-1; //not the identity
+        const size_t evaluationsPerChain = availableCCodes.size();
+
+        SECTION("Every level extends the beam with every transform, and every chain is tried with every compression") {
+            BeamSearcher searcher(settings, distanceToTarget);
+            CHECK(searcher.searchBest() == target);
+            CHECK(searcher.getLevelsSearched() == 3);
+            const size_t chains = 1 + extensionsPerChain + 2*settings.beamWidth*extensionsPerChain;
+            CHECK(searcher.getFitnessCacheStatistics().misses == chains*evaluationsPerChain);
+
+            const std::vector<Recipe> elite = searcher.getElite(3);
+            REQUIRE(elite.size() == 3);
+            CHECK(elite.front() == target);
+            CHECK(elite[1].getFitness() <= elite[2].getFitness());
+        }
+
+        SECTION("The search is deterministic, whatever the amount of threads") {
+            BeamSearcher single(settings, distanceToTarget);
+            const Recipe fromSingle = single.searchBest();
+            settings.evaluationThreads = 4;
+            BeamSearcher parallel(settings, distanceToTarget);
+            CHECK(parallel.searchBest() == fromSingle);
+            CHECK(parallel.getFitnessCacheStatistics().misses == single.getFitnessCacheStatistics().misses);
+        }
+
+        SECTION("The depth is capped by maxTransformAmount, and the budget is checked between levels") {
+            settings.maxTransformAmount = 1;
+            BeamSearcher shallow(settings, distanceToTarget);
+            CHECK(shallow.searchBest().getTListLength() <= 1);
+            CHECK(shallow.getLevelsSearched() == 1);
+
+            settings.maxTransformAmount = 6;
+            settings.evaluationBudget = evaluationsPerChain + 1;
+            BeamSearcher budgeted(settings, distanceToTarget);
+            budgeted.searchBest();
+            CHECK(budgeted.getLevelsSearched() == 1);
+        }
+
+        SECTION("The compressor uses it for the small segments") {
+            Block sample;
+            for (size_t i=0;i<512;i++) sample.push_back((i*i/5)%256);
+            settings.beamDepth = 2;
+            settings.beamSearchMaxSegmentSize = sample.size();
+            settings.seed = 1;
+            Evaluator::CacheStatistics statistics;
+            const Recipe first = EvolutionaryFileCompressor::evolveBestIndividualForBlock(sample, settings, statistics);
+            CHECK(statistics.misses == (1 + extensionsPerChain + settings.beamWidth*extensionsPerChain)*evaluationsPerChain);
+
+            settings.seed = 2; //the beam search doesn't depend on it
+            CHECK(EvolutionaryFileCompressor::evolveBestIndividualForBlock(sample, settings, statistics) == first);
+
+            settings.beamSearchMaxSegmentSize = sample.size()-1;
+            settings.generationCount = 3;
+            settings.populationSize = 10;
+            EvolutionaryFileCompressor::evolveBestIndividualForBlock(sample, settings, statistics);
+            CHECK(statistics.misses < extensionsPerChain*evaluationsPerChain);
+        }
+    }
+
+    TEST_CASE("Multi fidelity evaluation", "[Evolver]") {
+        const Recipe target({T_DeltaTransform, T_StrideTransform_4, T_SplitTransform}, C_HuffmanCompression);
+        const Evaluator::FitnessFunction distanceToTarget = distanceTo(target);
+        auto roughDistanceToTarget = [&](const Recipe& recipe) -> Evaluator::FitnessScore { //same ranking, different scale
+            return 10*distanceToTarget(recipe);
+        };
+
+        SECTION("Only the best of a batch are promoted to an actual evaluation") {
+            RandomGenerator::seedThisThread(23);
+            std::vector<Recipe> batch;
+            repeat(20, [&](){batch.push_back(Breeder::RandomIndividual(0, 6).makeIndividual());});
+            std::vector<size_t> indexes(batch.size());
+            std::iota(indexes.begin(), indexes.end(), 0);
+
+            Evaluator evaluator(distanceToTarget);
+            evaluator.setLowFidelityFitnessFunction(roughDistanceToTarget, 0.25);
+            evaluator.evaluateWithSuccessiveHalving(batch, indexes);
+
+            const Evaluator::CacheStatistics& statistics = evaluator.getCacheStatistics();
+            CHECK(statistics.misses + statistics.hits == 5);
+            CHECK(statistics.lowFidelity + statistics.hits == 15);
+
+            Evaluator::FitnessScore worstPromoted = 0;
+            for (const Recipe& recipe: batch)
+                if (recipe.isFitnessAssessed()) {
+                    CHECK(recipe.getFitness() == distanceToTarget(recipe));
+                    worstPromoted = std::max(worstPromoted, recipe.getFitness());
+                }
+            for (const Recipe& recipe: batch)
+                if (!recipe.isFitnessAssessed()) {
+                    CHECK(recipe.getFitness() >= worstPromoted);
+                    CHECK(distanceToTarget(recipe) >= worstPromoted);
+                }
+        }
+
+        SECTION("In the evolver, each generation promotes its best children by the halving schedule") {
+            Evolver::EvolutionSettings settings;
+            settings.populationSize = 30;
+            settings.generationCount = 30;
+            settings.seed = 3;
+            settings.promotedProportion = 0.3;
+
+            std::vector<Recipe> evaluated, scored; //in the current generation
+            auto countingFitness = [&](const Recipe& recipe) {
+                evaluated.push_back(recipe);
+                return distanceToTarget(recipe);
+            };
+            auto countingRoughFitness = [&](const Recipe& recipe) {
+                scored.push_back(recipe);
+                return roughDistanceToTarget(recipe);
+            };
+
+            Evolver evolver(settings, countingFitness);
+            evolver.setLowFidelityFitnessFunction(countingRoughFitness);
+            size_t generationsWithLowFidelity = 0;
+            while (true) {
+                evaluated.clear();
+                scored.clear();
+                if (!evolver.evolveNextGeneration()) break;
+                if (scored.empty()) continue;
+                generationsWithLowFidelity++;
+
+                CHECK_FALSE(evaluated.empty());
+                CHECK(evaluated.size() <= std::ceil(settings.promotedProportion*scored.size()));
+                Evaluator::FitnessScore worstPromoted = 0;
+                for (const Recipe& recipe: evaluated) worstPromoted = std::max(worstPromoted, distanceToTarget(recipe));
+                for (const Recipe& recipe: scored)
+                    if (std::find(evaluated.begin(), evaluated.end(), recipe) == evaluated.end())
+                        CHECK(distanceToTarget(recipe) >= worstPromoted);
+            }
+            CHECK(generationsWithLowFidelity > 0);
+            CHECK(evolver.getFitnessCacheStatistics().lowFidelity > 0);
+        }
+
+        SECTION("The champion is picked on the larger sample") {
+            Block block;
+            RandomGenerator::seedThisThread(29);
+            RandomInt<size_t> randomByte(0, 255);
+            for (size_t i=0;i<1024;i++) block.push_back(randomByte.choose());
+            for (size_t i=0;i<8*1024;i++) block.push_back('a' + i%3);
+
+            const Recipe stored({}, C_IdentityCompression);
+            const Recipe huffman({}, C_HuffmanCompression);
+            CHECK(EvolutionaryFileCompressor::pickChampion({stored, huffman}, block, 1024) == stored);
+            CHECK(EvolutionaryFileCompressor::pickChampion({stored, huffman}, block, block.size()) == huffman);
+            CHECK(EvolutionaryFileCompressor::pickChampion({huffman, huffman}, block, 1024) == huffman);
+        }
+
+        SECTION("The compressor scores the children on a smaller sample") {
+            Block block;
+            for (size_t i=0;i<4096;i++) block.push_back((i*i/7)%256);
+            Evolver::EvolutionSettings settings;
+            settings.populationSize = 12;
+            settings.generationCount = 6;
+            settings.seed = 5;
+            settings.lowFidelitySampleSize = 256;
+            settings.championSampleSize = block.size();
+
+            Evaluator::CacheStatistics statistics, otherStatistics;
+            const Recipe first = EvolutionaryFileCompressor::evolveBestIndividualForBlock(block, settings, statistics);
+            CHECK(statistics.lowFidelity > 0);
+            CHECK(EvolutionaryFileCompressor::evolveBestIndividualForBlock(block, settings, otherStatistics) == first);
+            CHECK(otherStatistics.misses == statistics.misses);
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include "../names.hpp"
+#include "../Kernels/SIMDSupport.hpp"
+#include "../Kernels/DeltaKernels.hpp"
+#include "../Kernels/StrideKernels.hpp"
+#include "../Kernels/RunKernels.hpp"
+#include "../Kernels/OffsetKernels.hpp"
+
+namespace GC {
+
+    Block makeKernelTestBlock(const size_t size) {
+        Block result(size);
+        for (size_t i=0;i<size;i++)
+            result[i] = (i*i*31 + i*7 + (i>>3)) % 256;
+        return result;
+    }
+
+    //the value of the little endian word of laneSize units starting at position
+    uint64_t readLaneWord(const Block& block, const size_t position, const size_t laneSize) {
+        uint64_t result = 0;
+        for (size_t i=0;i<laneSize;i++)
+            result |= ((uint64_t)block[position+i]) << (8*i);
+        return result;
+    }
+
+    TEST_CASE("Kernels", "[Kernels]") {
+        const size_t size = GENERATE(1, 2, 15, 16, 17, 31, 32, 33, 64, 100, 1000);
+        const Block input = makeKernelTestBlock(size);
+
+        for (const SIMDLevel level : getSupportedSIMDLevels()) {
+            INFO("Level: " << SIMDLevel_as_string(level) << ", size: " << size);
+
+            SECTION("Delta kernels agree with the scalar ones and are reversible") {
+                for (const size_t laneSize : {1, 2, 4, 8}) {
+                    INFO("Lane size: " << laneSize);
+                    const DeltaKernels& scalar = getDeltaKernels(SIMDLevel::Scalar, laneSize);
+                    const DeltaKernels& kernels = getDeltaKernels(level, laneSize);
+                    auto checkPair = [&](DeltaKernels::Kernel encode, DeltaKernels::Kernel decode,
+                                         DeltaKernels::Kernel scalarEncode) {
+                        Block expected(size), encoded(size), decoded(size);
+                        scalarEncode(input.data(), expected.data(), size);
+                        encode(input.data(), encoded.data(), size);
+                        CHECK(encoded == expected);
+
+                        decode(encoded.data(), decoded.data(), size);
+                        CHECK(decoded == input);
+
+                        Block inPlace = input;
+                        encode(inPlace.data(), inPlace.data(), size);
+                        CHECK(inPlace == expected);
+                        decode(inPlace.data(), inPlace.data(), size);
+                        CHECK(inPlace == input);
+                    };
+
+                    checkPair(kernels.deltaEncode, kernels.deltaDecode, scalar.deltaEncode);
+                    checkPair(kernels.xorEncode, kernels.xorDecode, scalar.xorEncode);
+                }
+            }
+
+            SECTION("Lane delta kernels subtract whole words") {
+                for (const size_t laneSize : {2, 4, 8}) {
+                    INFO("Lane size: " << laneSize);
+                    const uint64_t mask = (laneSize == 8) ? ~0ULL : ((1ULL << (8*laneSize))-1);
+                    Block encoded(size);
+                    getDeltaKernels(level, laneSize).deltaEncode(input.data(), encoded.data(), size);
+                    const size_t words = size/laneSize;
+                    for (size_t w=1;w<words;w++) {
+                        const uint64_t expected = (readLaneWord(input, w*laneSize, laneSize)-readLaneWord(input, (w-1)*laneSize, laneSize)) & mask;
+                        CHECK(readLaneWord(encoded, w*laneSize, laneSize) == expected);
+                    }
+                    for (size_t i=words*laneSize;i<size;i++)
+                        CHECK(encoded[i] == input[i]);
+                }
+            }
+
+            SECTION("Run kernels agree with the scalar ones") {
+                const RunKernels& scalar = getRunKernels(SIMDLevel::Scalar);
+                const RunKernels& kernels = getRunKernels(level);
+                Block runs(size);
+                for (size_t i=0;i<size;i++)
+                    runs[i] = (i/37)%3 == 0 ? 7 : input[i] % 2; //long runs of 7, and short random runs
+                for (const Block* data : std::vector<const Block*>{&input, &runs}) {
+                    CHECK(kernels.countRuns(data->data(), size) == scalar.countRuns(data->data(), size));
+                    for (size_t start = 0; start < size; start++)
+                        CHECK(kernels.findRunEnd(data->data(), start, size) == scalar.findRunEnd(data->data(), start, size));
+                }
+            }
+
+            SECTION("Offset kernels agree with the scalar ones and are reversible") {
+                const OffsetKernels& scalar = getOffsetKernels(SIMDLevel::Scalar);
+                const OffsetKernels& kernels = getOffsetKernels(level);
+                for (const Unit offset : {0, 1, 77, 255}) {
+                    Block expected(size), subtracted(size), added(size);
+                    scalar.subtractOffset(input.data(), expected.data(), size, offset);
+                    kernels.subtractOffset(input.data(), subtracted.data(), size, offset);
+                    CHECK(subtracted == expected);
+                    kernels.addOffset(subtracted.data(), added.data(), size, offset);
+                    CHECK(added == input);
+                }
+                for (size_t start = 0; start < size; start += 7)
+                    CHECK(kernels.minimum(input.data()+start, size-start) == scalar.minimum(input.data()+start, size-start));
+                CHECK(kernels.minimum(input.data(), 0) == 255);
+            }
+
+            SECTION("Stride kernels agree with the scalar ones and are reversible") {
+                for (const size_t stride : {2, 3, 4, 5, 8, 12, 16}) {
+                    INFO("Stride: " << stride);
+                    Block expected(size), gathered(size), scattered(size);
+                    strideGather(input.data(), expected.data(), size, stride, SIMDLevel::Scalar);
+                    strideGather(input.data(), gathered.data(), size, stride, level);
+                    CHECK(gathered == expected);
+
+                    strideScatter(gathered.data(), scattered.data(), size, stride, level);
+                    CHECK(scattered == input);
+                }
+            }
+        }
+    }
+}
@@ -1,5 +1,7 @@
 #include <catch2/catch.hpp>
 #include "../EvolutionaryFileCompressor/EvolutionaryFileCompressor.hpp"
+#include "../EvolutionaryFileCompressor/TilePipeline.hpp"
+#include "../Transformation/Transformations/BurrowsWheelerTransform.hpp"
 
 namespace GC {
 
@@ -47,10 +49,13 @@ namespace GC {
     THEN("The StackTransform is inverted correctly") { \
         CHECK(isInvertedCorrectly(T_StackTransform, input)); \
     } \
-    THEN("The StrideTransform is inverted correctly for arguments 2, 3, 4") { \
+    THEN("The StrideTransform is inverted correctly for arguments 2, 3, 4, 8, 12, 16") { \
         CHECK(isInvertedCorrectly(T_StrideTransform_2, input)); \
         CHECK(isInvertedCorrectly(T_StrideTransform_3, input)); \
         CHECK(isInvertedCorrectly(T_StrideTransform_4, input)); \
+        CHECK(isInvertedCorrectly(T_StrideTransform_8, input)); \
+        CHECK(isInvertedCorrectly(T_StrideTransform_12, input)); \
+        CHECK(isInvertedCorrectly(T_StrideTransform_16, input)); \
     } \
     THEN("The SubtractAverageTransform is inverted correctly") { \
         CHECK(isInvertedCorrectly(T_SubtractAverageTransform, input)); \
@@ -60,6 +65,17 @@ namespace GC {
     } \
     THEN("The SubMinAdaptiveTransform is inverted correctly") { \
         CHECK(isInvertedCorrectly(T_SubMinAdaptiveTransform, input)); \
+    } \
+    THEN("The BlockSortingTransform is inverted correctly") { \
+        CHECK(isInvertedCorrectly(T_BlockSortingTransform, input)); \
+    } \
+    THEN("The lane delta transforms are inverted correctly for 16, 32 and 64 bits") { \
+        CHECK(isInvertedCorrectly(T_DeltaTransform_16, input)); \
+        CHECK(isInvertedCorrectly(T_DeltaTransform_32, input)); \
+        CHECK(isInvertedCorrectly(T_DeltaTransform_64, input)); \
+        CHECK(isInvertedCorrectly(T_DeltaXORTransform_16, input)); \
+        CHECK(isInvertedCorrectly(T_DeltaXORTransform_32, input)); \
+        CHECK(isInvertedCorrectly(T_DeltaXORTransform_64, input)); \
     }
             WHEN("The input is a block of 2 bytes") {
                 const Unit firstValue = GENERATE(0, 1, 6, 128, 255);
@@ -94,5 +110,145 @@ namespace GC {
     }
 }
 
+    TEST_CASE("Corrupted block sorting input", "[Transforms]") {
+        SECTION("A body truncated after an escape symbol is rejected") {
+            Block truncated = BurrowsWheelerTransform::encodeHeader(1);
+            truncated.insert(truncated.end(), {5, 7, 255});
+            EvolutionaryFileCompressor::undoTransformCode(T_BlockSortingTransform, truncated);
+            CHECK(truncated.empty());
+        }
+
+        SECTION("A terminator past the end of the body is rejected") {
+            Block truncated = BurrowsWheelerTransform::encodeHeader(100);
+            truncated.insert(truncated.end(), {5, 7, 3});
+            EvolutionaryFileCompressor::undoTransformCode(T_BlockSortingTransform, truncated);
+            CHECK(truncated.empty());
+        }
+
+        SECTION("Truncating a valid output never reads past its end") {
+            Block sample;
+            for (size_t i=0;i<500;i++) sample.push_back((i*i*i) % 256);
+            Block transformed = sample;
+            EvolutionaryFileCompressor::applyTransformCode(T_BlockSortingTransform, transformed);
+            for (size_t size=1;size<transformed.size();size+=37) {
+                Block truncated(transformed.begin(), transformed.begin()+size);
+                EvolutionaryFileCompressor::undoTransformCode(T_BlockSortingTransform, truncated);
+                CHECK(truncated != sample);
+            }
+        }
+    }
+
 
-}
\ No newline at end of file
+    Block applyOneAfterTheOther(const std::vector<TCode>& tCodes, const Block& input) {
+        Block result = input;
+        for (const TCode tCode : tCodes)
+            EvolutionaryFileCompressor::applyTransformCode(tCode, result);
+        return result;
+    }
+
+    TEST_CASE("Transforming into buffers", "[Transforms]") {
+        Block sample;
+        for (size_t i=0;i<600;i++)
+            sample.push_back((i*i*7 + i/13) % 251);
+
+        SECTION("apply_into gives the same result as applying in place") {
+            for (const TCode tCode : availableTCodes) {
+                Block inPlace = sample;
+                EvolutionaryFileCompressor::applyTransformCode(tCode, inPlace);
+                Block output = {1, 2, 3}; //previous contents should be discarded
+                EvolutionaryFileCompressor::applyTransformCode(tCode, sample, output);
+                CHECK(inPlace == output);
+            }
+        }
+
+        SECTION("Reusing the same buffers across recipes gives the same result as fresh buffers") {
+            const std::vector<Recipe> recipes = {
+                    Recipe({T_StrideTransform_4, T_DeltaTransform, T_StackTransform, T_SplitTransform, T_SubtractAverageTransform, T_DeltaXORTransform}, C_HuffmanCompression),
+                    Recipe({T_BurrowsWheelerTransform, T_StackTransform, T_RunLengthTransform}, C_HuffmanCompression),
+                    Recipe({}, C_IdentityCompression),
+                    Recipe({T_SubtractXORAverageTransform, T_StrideTransform_3}, C_RunLengthCompression)};
+
+            EvolutionaryFileCompressor::TransformBuffers sharedBuffers;
+            for (const Recipe& recipe : recipes) {
+                EvolutionaryFileCompressor::TransformBuffers freshBuffers;
+                Block expected = sample;
+                for (const TCode tCode : recipe.tList)
+                    EvolutionaryFileCompressor::applyTransformCode(tCode, expected);
+
+                CHECK(EvolutionaryFileCompressor::applyRecipeTransforms(recipe, sample, freshBuffers) == expected);
+                CHECK(EvolutionaryFileCompressor::applyRecipeTransforms(recipe, sample, sharedBuffers) == expected);
+            }
+        }
+
+        SECTION("Recipes sharing a prefix reuse its stored result") {
+            const std::vector<Recipe> recipes = {
+                    Recipe({T_BurrowsWheelerTransform, T_StackTransform, T_RunLengthTransform}, C_HuffmanCompression),
+                    Recipe({T_BurrowsWheelerTransform, T_StackTransform}, C_HuffmanCompression),
+                    Recipe({T_BurrowsWheelerTransform, T_DeltaTransform}, C_LZWCompression),
+                    Recipe({T_StrideTransform_4, T_DeltaTransform, T_StackTransform}, C_HuffmanCompression),
+                    Recipe({T_StrideTransform_4, T_DeltaTransform, T_SplitTransform}, C_HuffmanCompression),
+                    Recipe({}, C_IdentityCompression),
+                    Recipe({T_BurrowsWheelerTransform, T_StackTransform, T_RunLengthTransform}, C_HuffmanCompression)};
+
+            for (const size_t capacity : {TransformPrefixCache::defaultCapacityInBytes, 2*sample.size()}) { //the second one has to evict
+                TransformPrefixCache prefixCache(capacity);
+                EvolutionaryFileCompressor::TransformBuffers buffers;
+                for (const Recipe& recipe : recipes) {
+                    const Block expected = applyOneAfterTheOther(recipe.tList.toVector(), sample);
+                    CHECK(EvolutionaryFileCompressor::applyRecipeTransforms(recipe, sample, buffers, prefixCache) == expected);
+                    CHECK(prefixCache.getStoredBytes() <= capacity);
+                }
+                CHECK(prefixCache.getStatistics().transformsReused > 0);
+                if (capacity < TransformPrefixCache::defaultCapacityInBytes)
+                    CHECK(prefixCache.getStatistics().evictions > 0);
+                else
+                    CHECK(prefixCache.getStatistics().transformsApplied == 8); //BWTra, STACK, RLE, DELTA, STRD4, DELTA, STACK, SPLIT
+            }
+        }
+    }
+
+    TEST_CASE("Tile streamed transforms", "[Transforms]") {
+        Block block;
+        for (size_t i=0;i<3001;i++)
+            block.push_back((i%50 < 20) ? (i*i*7)%256 : 100+(i/9)%16); //alternates noisy and smooth parts, so that SubMin splits it
+
+        const std::vector<std::vector<TCode>> runs = {
+                {T_DeltaTransform, T_StackTransform},
+                {T_SubMinAdaptiveTransform, T_DeltaXORTransform},
+                {T_SplitTransform, T_DeltaTransform_32, T_SubtractAverageTransform},
+                {T_DeltaTransform_16, T_SubtractXORAverageTransform, T_SubMinAdaptiveTransform, T_DeltaXORTransform_64},
+                {T_SubtractAverageTransform, T_SplitTransform, T_SubtractXORAverageTransform, T_IdentityTransform, T_SubMinAdaptiveTransform},
+                {T_StackTransform, T_DeltaXORTransform_16, T_DeltaTransform_64, T_SplitTransform, T_DeltaTransform}};
+
+        SECTION("Streaming gives the same result as applying the transforms one after the other") {
+            for (const auto& run : runs) {
+                const Block expected = applyOneAfterTheOther(run, block);
+                for (const size_t tileSize : {1, 3, 7, 64, 1000, 4096}) {
+                    Block streamed;
+                    TilePipeline::apply(run.data(), run.size(), block, streamed, tileSize);
+                    CHECK(streamed == expected);
+                }
+            }
+        }
+
+        SECTION("Global transforms end the streamable runs") {
+            const std::vector<TCode> recipe = {T_DeltaTransform, T_SplitTransform, T_BurrowsWheelerTransform, T_StackTransform, T_StrideTransform_4};
+            CHECK(TilePipeline::streamableRunEnd(recipe.data(), recipe.size(), 0) == 2);
+            CHECK(TilePipeline::streamableRunEnd(recipe.data(), recipe.size(), 2) == 2);
+            CHECK(TilePipeline::streamableRunEnd(recipe.data(), recipe.size(), 3) == 4);
+
+            const std::vector<TCode> averages = {T_SubtractAverageTransform, T_DeltaTransform, T_SubtractXORAverageTransform, T_SplitTransform};
+            CHECK(TilePipeline::streamableRunEnd(averages.data(), averages.size(), 0) == 2);
+            CHECK(TilePipeline::streamableRunEnd(averages.data(), averages.size(), 2) == 4);
+        }
+
+        SECTION("Large blocks are streamed by applyRecipeTransforms") {
+            Block large;
+            for (size_t i=0;i<3*TilePipeline::defaultTileSize+17;i++)
+                large.push_back(block[i%block.size()]+(i/block.size()));
+            const Recipe recipe({T_SubMinAdaptiveTransform, T_DeltaTransform, T_StrideTransform_3, T_SubtractAverageTransform, T_StackTransform}, C_HuffmanCompression);
+            EvolutionaryFileCompressor::TransformBuffers buffers;
+            CHECK(EvolutionaryFileCompressor::applyRecipeTransforms(recipe, large, buffers) == applyOneAfterTheOther(recipe.tList.toVector(), large));
+        }
+    }
+}
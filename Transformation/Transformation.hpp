@@ -23,6 +23,17 @@ namespace GC {
             block.swap(newBlock);
         }
 
+        /**
+         * Writes the transformed block onto output, which is resized as necessary.
+         * Transforms that override this reuse the capacity of output, so applying them to the same buffers repeatedly
+         * does not allocate. The default falls back on apply_copy.
+         * @param block the block to be transformed, must not be the same object as output
+         * @param output the destination, its previous contents are discarded
+         */
+        virtual void apply_into(const Block& block, Block& output) const {
+            output = apply_copy(block);
+        }
+
         virtual Block undo_copy(const Block& block) const = 0;
 
         virtual void undo(Block& block) const {
@@ -30,6 +41,13 @@ namespace GC {
             block.swap(undoneBlock);
         }
 
+        /**
+         * The dual of apply_into
+         */
+        virtual void undo_into(const Block& block, Block& output) const {
+            output = undo_copy(block);
+        }
+
     protected:
         Transformation(){}
     };
@@ -0,0 +1,8 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#include "BlockSortingTransform.hpp"
+
+namespace GC {
+} // GC
@@ -0,0 +1,122 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_BLOCKSORTINGTRANSFORM_HPP
+#define EVOCOM_BLOCKSORTINGTRANSFORM_HPP
+
+#include "../Transformation.hpp"
+#include "../../Utilities/utilities.hpp"
+#include "BurrowsWheelerTransform.hpp"
+#include "StackTransform.hpp"
+
+namespace GC {
+
+    /**
+     * Performs BWT, move-to-front and zero run length encoding as a single stage, ie the equivalent of {BWTra, STACK, RLE0}.
+     * The BWT is the only part that needs the whole block, the rest is done in one pass while the BWT output is still in cache,
+     * so no intermediate Blocks are materialised.
+     *
+     * The output is [BWT header][body], where the body uses these symbols:
+     *    0, 1       : a run of zeros (after MTF), the length is written in bijective base 2 (RUNA = 0, RUNB = 1), least significant first
+     *    2 .. 254   : the MTF value v = symbol-1
+     *    255, x     : the MTF value v = 254+x (only 254 and 255 need this, and they are rare after MTF)
+     */
+    class BlockSortingTransform : public Transformation {
+    private:
+        static constexpr Unit runA = 0;
+        static constexpr Unit runB = 1;
+        static constexpr Unit escapeSymbol = 255;
+        static constexpr Unit largestDirectValue = 253; //values above this are written as escapeSymbol followed by an offset
+
+    public:
+        std::string to_string() const {return "{BlockSortingTransform}";}
+
+        Block apply_copy(const Block& block) const {
+            if (block.empty()) return {};
+            const size_t blockLength = block.size();
+            Block sorted(blockLength);
+            std::vector<int> temp(blockLength);
+            const int terminatorPosition = sais_bwt(block.data(), sorted.data(), temp.data(), blockLength);
+
+            Block result = BurrowsWheelerTransform::encodeHeader(terminatorPosition);
+            result.reserve(result.size()+blockLength+1);
+
+            size_t pendingZeros = 0;
+            auto flushZeros = [&]() {
+                while (pendingZeros > 0) {
+                    if (pendingZeros & 1) {
+                        result.push_back(runA);
+                        pendingZeros = (pendingZeros-1)>>1;
+                    }
+                    else {
+                        result.push_back(runB);
+                        pendingZeros = (pendingZeros-2)>>1;
+                    }
+                }
+            };
+
+            auto pushMTFValue = [&](const Unit value) {
+                if (value <= largestDirectValue)
+                    result.push_back(value+1);
+                else {
+                    result.push_back(escapeSymbol);
+                    result.push_back(value-largestDirectValue-1);
+                }
+            };
+
+            StackTransform::UnitTable table = StackTransform::getInitialTable();
+            for (const Unit unit : sorted) {
+                const Unit value = StackTransform::findInTableAndUpdate(unit, table);
+                if (value == 0)
+                    pendingZeros++;
+                else {
+                    flushZeros();
+                    pushMTFValue(value);
+                }
+            }
+            flushZeros();
+            return result;
+        }
+
+        Block undo_copy(const Block& block) const {
+            if (block.empty()) return {};
+            size_t headerSize;
+            const size_t terminatorPosition = BurrowsWheelerTransform::readHeader(block, headerSize);
+
+            Block sorted;
+            sorted.reserve(block.size()*2);
+            StackTransform::UnitTable table = StackTransform::getInitialTable();
+
+            size_t pendingZeros = 0;
+            size_t runWeight = 1;
+            auto flushZeros = [&]() {
+                sorted.insert(sorted.end(), pendingZeros, table[0]); //a 0 in MTF means repeating the front of the table
+                pendingZeros = 0;
+                runWeight = 1;
+            };
+
+            for (size_t i=headerSize;i<block.size();i++) {
+                const Unit symbol = block[i];
+                if (symbol == runA || symbol == runB) {
+                    pendingZeros += runWeight << (symbol == runB);
+                    runWeight <<= 1;
+                    continue;
+                }
+                flushZeros();
+                if (symbol == escapeSymbol && i+1 == block.size()) {
+                    LOG("ERROR: the BlockSortingTransform body ends with an escape symbol, it's corrupted");
+                    return {};
+                }
+                const Unit value = (symbol == escapeSymbol) ? block[++i]+largestDirectValue+1 : symbol-1;
+                sorted.push_back(StackTransform::getNthFromTableAndUpdate(value, table));
+            }
+            flushZeros();
+
+            return BWT_Helper::undoUsingLFMapping(sorted.data(), sorted.size(), terminatorPosition);
+        }
+    };
+
+} // GC
+
+#endif //EVOCOM_BLOCKSORTINGTRANSFORM_HPP
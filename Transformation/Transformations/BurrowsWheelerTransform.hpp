@@ -9,6 +9,8 @@
 #include <set>
 #include <unordered_map>
 #include <algorithm>
+#include <array>
+#include <cstdint>
 
 #include "../Transformation.hpp"
 #include "../../Utilities/utilities.hpp"
@@ -131,6 +133,48 @@ namespace GC {
 
 
 
+        /**
+         * Inverts the output of sais_bwt in linear time, by walking the LF mapping backwards from the row starting with $
+         * The BWT as returned by sais_bwt omits the terminator, which would be at terminatorPosition.
+         * @param bwt the transformed units (without the terminator)
+         * @param size the amount of units in bwt
+         * @param terminatorPosition the value returned by sais_bwt
+         * @return the original block, or an empty one when the terminator position is past the end (a corrupted input)
+         */
+        static Block undoUsingLFMapping(const Unit* bwt, const size_t size, const Index terminatorPosition) {
+            if (size == 0) return {};
+            if (terminatorPosition > size) {
+                LOG("ERROR: the BWT terminator is at", terminatorPosition, "but there are only", size, "units, the input is corrupted");
+                return {};
+            }
+            auto lastColumnAt = [&](const Index row) -> Unit { //the last column, with the terminator reinserted
+                return row < terminatorPosition ? bwt[row] : bwt[row-1];
+            };
+
+            std::array<uint32_t, 256> firstRowOfUnit{0};
+            for (size_t i=0;i<size;i++) firstRowOfUnit[bwt[i]]++;
+            uint32_t cumulative = 1; //row 0 is the one starting with the terminator
+            for (auto& count : firstRowOfUnit) {
+                const uint32_t amount = count;
+                count = cumulative;
+                cumulative += amount;
+            }
+
+            std::vector<uint32_t> lfMapping(size+1);
+            for (Index row=0;row<=size;row++)
+                if (row != terminatorPosition)
+                    lfMapping[row] = firstRowOfUnit[lastColumnAt(row)]++;
+
+            Block result(size);
+            Index row = 0;
+            for (size_t i=size;i>0;i--) {
+                result[i-1] = lastColumnAt(row);
+                row = lfMapping[row];
+            }
+            return result;
+        }
+
+
         /////////Experimental
 
         static bool E_less_lexicographic(const Block& block, const Index startA, const Index startB) {
@@ -190,10 +234,10 @@ namespace GC {
 
 
     class BurrowsWheelerTransform : public Transformation{
-    private:
+    public: //the header format is shared with BlockSortingTransform
 
         static std::vector<Unit> encodeHeader(const size_t terminator) {
-            const size_t bitSize = std::max<size_t>(floor_log2(terminator), 1);
+            const size_t bitSize = floor_log2(terminator)+1; //floor_log2 is the position of the highest bit, so the amount of bits is one more
             const size_t bytesRequired = greaterMultipleOf(bitSize, 7)/7;
             std::vector<Unit> result;
             for (size_t i=0;i<bytesRequired;i++) {
@@ -213,6 +257,27 @@ namespace GC {
             return result;
         }
 
+        /**
+         * Reads the header written by encodeHeader from the start of the block
+         * @param block the transformed block, starting with the header
+         * @param headerSize is set to the amount of bytes occupied by the header
+         * @return the position of the terminator
+         */
+        static size_t readHeader(const Block& block, size_t& headerSize) {
+            auto isEndOfHeader = [&](const Unit byte) -> bool { //a byte is the end of the header if the first bit from the left is 0
+                return !(byte>>7);
+            };
+
+            std::vector<Unit> header;
+            for (const Unit byte: block) {
+                header.push_back(byte);
+                if (isEndOfHeader(byte))
+                    break;
+            }
+            headerSize = header.size();
+            return decodeHeader(header);
+        }
+
     public:
         std::string to_string() const { return "{BWTransform}";}
 
@@ -224,19 +289,9 @@ namespace GC {
             return result;
         }
         Block undo_copy(const Block& block) const {
-            auto isEndOfHeader = [&](const Unit byte) -> bool { //a byte is the end of the header if the first bit from the left is 0
-                return !(byte>>7);
-            };
-
-            std::vector<Unit> header;
-            for (const Unit byte: block) {
-                header.push_back(byte);
-                if (isEndOfHeader(byte))
-                    break;
-            }
-            const size_t positionOfTerminator = decodeHeader(header);
-            const Block body(block.begin()+header.size(), block.end());
-            return BWT_Helper::undo(body, positionOfTerminator);
+            size_t headerSize;
+            const size_t positionOfTerminator = readHeader(block, headerSize);
+            return BWT_Helper::undoUsingLFMapping(block.data()+headerSize, block.size()-headerSize, positionOfTerminator);
         }
 
 
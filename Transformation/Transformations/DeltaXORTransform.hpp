@@ -6,6 +6,7 @@
 #define DISS_SIMPLEPROTOTYPE_DELTAXORTRANSFORM_HPP
 
 #include "../Transformation.hpp"
+#include "../../Kernels/DeltaKernels.hpp"
 
 namespace GC {
     class DeltaXORTransform : public Transformation {
@@ -18,28 +19,38 @@ namespace GC {
         }
 
         Block apply_copy(const Block& block) const {
-            ASSERT_NOT_EMPTY(block);
             Block result;
-            result.push_back(block[0]);
-            auto pushDifference = [&](const size_t index) {
-                result.push_back(block[index+1]^block[index]);
-            };
-            for (int i=0;i<block.size()-1;i++)
-                pushDifference(i);
+            apply_into(block, result);
             return result;
         }
 
-        Block undo_copy(const Block& block) const {
+        void apply_into(const Block& block, Block& output) const {
             ASSERT_NOT_EMPTY(block);
+            output.resize(block.size());
+            getDeltaKernels().xorEncode(block.data(), output.data(), block.size());
+        }
+
+        void apply(Block& block) const {
+            ASSERT_NOT_EMPTY(block);
+            getDeltaKernels().xorEncode(block.data(), block.data(), block.size());
+        }
+
+        Block undo_copy(const Block& block) const {
             Block result;
-            Unit toBePushed = block[0];
-            result.push_back(toBePushed);
-            for (int i=1;i<block.size();i++) {
-                toBePushed^=block[i];
-                result.push_back(toBePushed);
-            }
+            undo_into(block, result);
             return result;
         }
+
+        void undo_into(const Block& block, Block& output) const {
+            ASSERT_NOT_EMPTY(block);
+            output.resize(block.size());
+            getDeltaKernels().xorDecode(block.data(), output.data(), block.size());
+        }
+
+        void undo(Block& block) const {
+            ASSERT_NOT_EMPTY(block);
+            getDeltaKernels().xorDecode(block.data(), block.data(), block.size());
+        }
     };
 }
 #endif //DISS_SIMPLEPROTOTYPE_DELTAXORTRANSFORM_HPP
@@ -22,6 +22,13 @@ namespace GC {
 
         void apply(Block& block) const {}
         void undo(Block& block) const{}
+
+        void apply_into(const Block& block, Block& output) const {
+            output = block;
+        }
+        void undo_into(const Block& block, Block& output) const {
+            output = block;
+        }
     };
 
 } // GC
@@ -0,0 +1,81 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_LANEDELTATRANSFORM_HPP
+#define EVOCOM_LANEDELTATRANSFORM_HPP
+
+#include "../Transformation.hpp"
+#include "../../Kernels/DeltaKernels.hpp"
+
+namespace GC {
+
+    /**
+     * The same as DeltaTransform (or DeltaXORTransform), but the block is read as little endian words of 2, 4 or 8 units.
+     * On 16 bit audio or 32 bit counters the byte-wise delta produces noisy carries, while the word-wise one produces small values.
+     * If the size is not a multiple of the lane size, the last few units are left as they are.
+     */
+    class LaneDeltaTransform : public Transformation {
+    public:
+        LaneDeltaTransform(size_t laneSize, bool isXOR) : laneSize(laneSize), isXOR(isXOR) {
+            ASSERT(laneSize == 2 || laneSize == 4 || laneSize == 8);
+        };
+
+        const size_t laneSize; //in units
+        const bool isXOR;
+
+        std::string to_string() const {
+            std::stringstream ss;
+            ss << "{LaneDeltaTransform, laneSize =" << laneSize << (isXOR ? ", xor}" : "}");
+            return ss.str();
+        }
+
+        Block apply_copy(const Block& block) const {
+            Block result;
+            apply_into(block, result);
+            return result;
+        }
+
+        void apply_into(const Block& block, Block& output) const {
+            ASSERT_NOT_EMPTY(block);
+            output.resize(block.size());
+            getEncoder()(block.data(), output.data(), block.size());
+        }
+
+        void apply(Block& block) const {
+            ASSERT_NOT_EMPTY(block);
+            getEncoder()(block.data(), block.data(), block.size());
+        }
+
+        Block undo_copy(const Block& block) const {
+            Block result;
+            undo_into(block, result);
+            return result;
+        }
+
+        void undo_into(const Block& block, Block& output) const {
+            ASSERT_NOT_EMPTY(block);
+            output.resize(block.size());
+            getDecoder()(block.data(), output.data(), block.size());
+        }
+
+        void undo(Block& block) const {
+            ASSERT_NOT_EMPTY(block);
+            getDecoder()(block.data(), block.data(), block.size());
+        }
+
+    private:
+        DeltaKernels::Kernel getEncoder() const {
+            const DeltaKernels& kernels = getDeltaKernels(laneSize);
+            return isXOR ? kernels.xorEncode : kernels.deltaEncode;
+        }
+
+        DeltaKernels::Kernel getDecoder() const {
+            const DeltaKernels& kernels = getDeltaKernels(laneSize);
+            return isXOR ? kernels.xorDecode : kernels.deltaDecode;
+        }
+    };
+
+} // GC
+
+#endif //EVOCOM_LANEDELTATRANSFORM_HPP
@@ -7,6 +7,8 @@
 
 #include "../../Utilities/utilities.hpp"
 #include "../Transformation.hpp"
+#include "../../Kernels/RunKernels.hpp"
+#include <cstring>
 
 namespace GC {
 
@@ -17,62 +19,59 @@ namespace GC {
         std::string to_string() const {return "{RunLengthTransform}";}
 
         Block apply_copy(const Block& block) const {
-            if (block.empty())
-                return block;
-
-
-
-            Unit repeatingUnit;
-            Unit runLength;
+            Block result;
+            apply_into(block, result);
+            return result;
+        }
 
-            auto startNewRun = [&](const Unit newUnit) {
-                repeatingUnit = newUnit;
-                runLength = 1;
-            };
+        /**
+         * The output is a sequence of (unit, runLength) pairs, where runs longer than 255 are split
+         */
+        void apply_into(const Block& block, Block& result) const {
+            result.clear(); //keeps the capacity
+            if (block.empty())
+                return;
 
-            startNewRun(block[0]);
             const size_t maximumStorableRunLength = typeVolume<Unit>()-1; //for a byte that's 255
-            Block result;
+            const auto findRunEnd = getRunKernels().findRunEnd;
+            result.reserve(block.size()*2);
 
-            auto pushRLPair = [&]() {
+            auto pushRLPair = [&](const Unit repeatingUnit, const size_t runLength) {
                 result.push_back(repeatingUnit);
                 result.push_back(runLength);
             };
 
-            for (size_t i=1;i<block.size();i++) {
-                Unit currentUnit = block[i];
-                if (currentUnit == repeatingUnit) {
-                    if (runLength == maximumStorableRunLength) {
-                        pushRLPair();
-                        startNewRun(currentUnit);
-                    }
-                    else
-                        runLength++;
-                }
-                else {
-                    pushRLPair();
-                    startNewRun(currentUnit);
-                }
+            for (size_t runStart = 0; runStart < block.size();) {
+                const size_t runEnd = findRunEnd(block.data(), runStart, block.size());
+                size_t runLength = runEnd-runStart;
+                for (; runLength > maximumStorableRunLength; runLength -= maximumStorableRunLength)
+                    pushRLPair(block[runStart], maximumStorableRunLength);
+                pushRLPair(block[runStart], runLength);
+                runStart = runEnd;
             }
-            pushRLPair();
-
-            return result;
         }
 
 
         Block undo_copy(const Block& block) const {
-            ASSERT_EQUALS(block.size()%2, 0);
             Block result;
-            auto unpackRLPairIntoResult = [&result](const Unit repeatingUnit, const Unit runLength) {
-                repeat(runLength, [&result, &repeatingUnit](){result.push_back(repeatingUnit);});
-            };
-
-            for (size_t i=0;i<block.size();i+=2)  //note that we're reading in pairs
-                unpackRLPairIntoResult(block[i], block[i+1]);
-
+            undo_into(block, result);
             return result;
         }
 
+        void undo_into(const Block& block, Block& result) const {
+            ASSERT_EQUALS(block.size()%2, 0);
+            size_t totalLength = 0;
+            for (size_t i=1;i<block.size();i+=2)
+                totalLength += block[i];
+
+            result.resize(totalLength);
+            Unit* writePosition = result.data();
+            for (size_t i=0;i<block.size();i+=2) {  //note that we're reading in pairs
+                std::memset(writePosition, block[i], block[i+1]);
+                writePosition += block[i+1];
+            }
+        }
+
     };
 
 } // GC
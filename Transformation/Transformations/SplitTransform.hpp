@@ -22,25 +22,31 @@ namespace GC {
 
         Block apply_copy(const Block& block) const {
             Block result;
-            auto addSplit = [&result](const Unit u) {
-                result.push_back(u>>bitsInEachSplit);
-                result.push_back(((Unit)(u<<bitsInEachSplit))>>bitsInEachSplit);
-            };
-            for (const auto& unit: block)
-                addSplit(unit);
+            apply_into(block, result);
             return result;
         }
 
+        void apply_into(const Block& block, Block& output) const {
+            output.resize(block.size()*2);
+            for (size_t i=0;i<block.size();i++) {
+                const Unit u = block[i];
+                output[2*i] = u>>bitsInEachSplit;
+                output[2*i+1] = ((Unit)(u<<bitsInEachSplit))>>bitsInEachSplit;
+            }
+        }
+
         Block undo_copy(const Block& block) const {
-            ASSERT_EQUALS(block.size()%2, 0);
             Block result;
-            auto addJoint = [&result](const Unit first, const Unit second) {
-                result.push_back((first<<bitsInEachSplit)|second);
-            };
-            for (size_t i=0;i<block.size();i+=2)
-                addJoint(block[i], block[i+1]);
+            undo_into(block, result);
             return result;
         }
+
+        void undo_into(const Block& block, Block& output) const {
+            ASSERT_EQUALS(block.size()%2, 0);
+            output.resize(block.size()/2);
+            for (size_t i=0;i<output.size();i++)
+                output[i] = (block[2*i]<<bitsInEachSplit)|block[2*i+1];
+        }
     };
 
 } // GC
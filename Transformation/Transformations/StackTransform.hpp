@@ -6,7 +6,8 @@
 #define DISS_SIMPLEPROTOTYPE_STACKTRANSFORM_HPP
 
 #include <numeric>
-#include <forward_list>
+#include <array>
+#include <cstring>
 #include "../Transformation.hpp"
 #include "../../Utilities/utilities.hpp"
 
@@ -15,72 +16,75 @@ namespace GC {
     class StackTransform : public Transformation {
     public:
 
-        using UnitList = std::forward_list<Unit>;
+        using UnitTable = std::array<Unit, typeVolume<Unit>()>;
         static const size_t maxValueOfUnit = typeVolume<Unit>();
 
         StackTransform() {};
 
         std::string to_string() const {return "{NewStackTransform}";}
 
-        static UnitList getInitialList() {
-            UnitList result;
-            auto currentEnd = result.before_begin();
-            for (size_t i=0;i<maxValueOfUnit;i++) {
-                result.emplace_after(currentEnd, i);
-                currentEnd++;
-            }
+        static UnitTable getInitialTable() {
+            UnitTable result;
+            std::iota(result.begin(), result.end(), 0);
             return result;
         }
 
-
-
         /**
          * Finds where the given unit was in the stack, and also updates the stack to have that on top
+         * The stack is a flat array, so moving an item to the top is a single memmove
          * @param u the unit we're looking for
          * @return  where u was in the stack, counting from the top, 0 indexed
          */
-        static Unit findInListAndUpdate(const Unit u, UnitList& mainList) {
-            Unit where = 0;
-            auto beforeIter = mainList.before_begin();
-            auto iter = mainList.begin();
-            while (true) {//dangerous
-                if (*iter == u) break;
-                where++;
-                beforeIter = iter;
-                iter++;
-            }
-            mainList.erase_after(beforeIter);
-            mainList.emplace_front(u);
+        static Unit findInTableAndUpdate(const Unit u, UnitTable& table) {
+            if (table[0] == u) return 0;
+            const Unit where = std::find(table.begin(), table.end(), u) - table.begin();
+            std::memmove(table.data()+1, table.data(), where);
+            table[0] = u;
             return where;
         }
 
-        Block apply_copy(const Block& block) const {
-            //stack is initially all the values in the unit, in order, with 0 at the top
-            UnitList encodingList = getInitialList();
-
-            Block result(block.size());
-            for (size_t i=0;i<result.size();i++)
-                result[i] = findInListAndUpdate(block[i], encodingList);
+        static Unit getNthFromTableAndUpdate(const Unit position, UnitTable& table) {
+            const Unit result = table[position];
+            std::memmove(table.data()+1, table.data(), position);
+            table[0] = result;
             return result;
         }
 
-        static Unit getNthFromListAndUpdate(const Unit position, UnitList& mainStack) {
-            auto beforeIter = mainStack.before_begin();
-            repeat(position, [&](){beforeIter++;});
-            auto iter = beforeIter; iter++;
-            Unit result = *iter;
-            mainStack.erase_after(beforeIter);
-            mainStack.emplace_front(result);
+        Block apply_copy(const Block& block) const {
+            Block result;
+            apply_into(block, result);
             return result;
         }
 
+        void apply_into(const Block& block, Block& output) const {
+            //stack is initially all the values in the unit, in order, with 0 at the top
+            UnitTable encodingTable = getInitialTable();
+            output.resize(block.size());
+            for (size_t i=0;i<block.size();i++)
+                output[i] = findInTableAndUpdate(block[i], encodingTable);
+        }
+
+        void apply(Block& block) const {
+            UnitTable encodingTable = getInitialTable();
+            for (Unit& unit : block)
+                unit = findInTableAndUpdate(unit, encodingTable);
+        }
+
         Block undo_copy(const Block& block) const {
-            UnitList encodingList = getInitialList(); //needs to start with the same stack as apply_copy
-            Block result(block.size());
-            for (size_t i=0;i<result.size();i++)
-                result[i] = getNthFromListAndUpdate(block[i], encodingList);
+            Block result;
+            undo_into(block, result);
             return result;
+        }
+
+        void undo_into(const Block& block, Block& output) const {
+            output = block;
+            undo(output);
+        }
 
+        void undo(Block& block) const {
+            UnitTable encodingTable = getInitialTable(); //needs to start with the same stack as apply
+            for (Unit& unit : block)
+                unit = getNthFromTableAndUpdate(unit, encodingTable);
         }
 
     };
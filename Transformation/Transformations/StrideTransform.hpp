@@ -5,6 +5,7 @@
 #ifndef DISS_SIMPLEPROTOTYPE_STRIDETRANSFORM_HPP
 #define DISS_SIMPLEPROTOTYPE_STRIDETRANSFORM_HPP
 #include "../Transformation.hpp"
+#include "../../Kernels/StrideKernels.hpp"
 
 namespace GC {
 
@@ -14,7 +15,7 @@ namespace GC {
         StrideTransform(size_t stride) : stride(stride) { ASSERT_GREATER(stride, 1);};
 
 
-        const size_t stride;//TODO consider making stride a template parameter
+        const size_t stride; //the common strides have kernels specialised at compile time, see StrideKernels
 
         std::string to_string() const {
             std::stringstream ss;
@@ -23,42 +24,30 @@ namespace GC {
         }
 
         Block apply_copy(const Block& block) const {
-            //TODO make sure that this works even if block.size() % stride != 0
-            std::vector<Block> separations(stride);
-            for (size_t index = 0; index < block.size(); index++)
-                separations[index%stride].push_back(block[index]);
-
             Block result;
-            auto appendToResult = [&result](const auto& subBlock) {
-                result.insert(result.end(), subBlock.begin(), subBlock.end());
-            };
-            std::for_each(separations.begin(), separations.end(), appendToResult);
+            apply_into(block, result);
             return result;
         }
 
-        Block undo_copy(const Block& block) const {
-            auto getSizeOfSeparation = [&](size_t whichSeparation) {
-                const size_t blockSize = block.size();
-                return (blockSize / stride)+(whichSeparation<(blockSize % stride));
-            };
-
-            std::vector<size_t> separationStarts(stride);
-            size_t currentSeparationStart = 0;
-            for (size_t i = 0;i < stride; i++) {
-                separationStarts[i] = currentSeparationStart;
-                currentSeparationStart+=getSizeOfSeparation(i);
-            }
+        /**
+         * The units with index i%stride == 0 are placed first, then the ones with i%stride == 1, and so on.
+         * This also works when the block size is not a multiple of the stride, in which case the first separations are longer
+         */
+        void apply_into(const Block& block, Block& output) const {
+            output.resize(block.size());
+            strideGather(block.data(), output.data(), block.size(), stride);
+        }
 
+        Block undo_copy(const Block& block) const {
             Block result;
-            auto addFromSeparationIndex = [&](const size_t whichSeparation) {
-                result.push_back(block[separationStarts[whichSeparation]++]);
-            };
-
-            for (size_t i = 0;i < block.size();i++)
-                addFromSeparationIndex(i%stride);
-
+            undo_into(block, result);
             return result;
         }
+
+        void undo_into(const Block& block, Block& output) const {
+            output.resize(block.size());
+            strideScatter(block.data(), output.data(), block.size(), stride);
+        }
     };
 
 } // GC
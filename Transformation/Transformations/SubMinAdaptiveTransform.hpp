@@ -5,34 +5,27 @@
 #ifndef EVOCOM_SUBMINADAPTIVETRANSFORM_HPP
 #define EVOCOM_SUBMINADAPTIVETRANSFORM_HPP
 #include "../Transformation.hpp"
+#include "../../Kernels/OffsetKernels.hpp"
 
 
 namespace GC {
 
+    /**
+     * Splits the block in subsegments, and subtracts from each unit the minimum of its subsegment.
+     * A subsegment ends where the minimum of the 4 units before differs from the minimum of the 4 units after by at least the threshold.
+     * Each subsegment is written as [minimum][length][units - minimum], where a length of 0 means that it continues until the end.
+     *
+     * Everything is done in one pass: the 4-unit window minimums are computed once each and kept in a small ring,
+     * the minimum of the current subsegment is tracked as it grows, and when a subsegment ends it's subtracted (with a vector kernel)
+     * straight into the output, while it's still in cache.
+     */
     class SubMinAdaptiveTransform : public Transformation{
-    private: //types & constants
-        using BlockIter = Block::const_iterator;
-        static const size_t peekDistance = 3;
-
-        struct SubsegmentBounds {
-            const size_t startIndex;
-            const size_t endIndex; //excluded,
-            //also if endIndex is 0, it means that the segment continues until the end of the block
-
-            SubsegmentBounds(const size_t startIndex, const size_t endIndex) :
-                    startIndex(startIndex),
-                    endIndex(endIndex) {}
-        };
-
-        struct SubsegmentDescriptor {
-            const Unit minimum;
-            const size_t length;
-
-            SubsegmentDescriptor(const Unit minimum, const size_t length) :
-                minimum(minimum),
-                length(length){
-            }
-        };
+    private: //constants
+        static constexpr size_t peekDistance = 3;
+        static constexpr size_t windowSize = peekDistance+1;
+        static constexpr size_t threshold = 3;
+        static constexpr size_t minSegmentSize = 4;
+        static constexpr size_t maxSegmentSize = 254; //so that the length (which is one more) fits in a unit
 
     public:
 
@@ -40,104 +33,84 @@ namespace GC {
 
         Block apply_copy(const Block& block) const override {
             Block result;
-
-            auto getIteratorsOfSubsegment = [&](const SubsegmentBounds& bounds) -> std::pair<BlockIter, BlockIter> {
-                if (bounds.endIndex != 0)
-                    return {block.begin()+bounds.startIndex, block.begin()+bounds.endIndex};
-                else
-                    return {block.begin()+bounds.startIndex, block.end()};
-            };
-
-            auto processHeader = [&](const SubsegmentBounds& bounds) {
-                //LOG("Processing the header with bounds", bounds.startIndex, bounds.endIndex);
-                const auto [startIterator, endIterator] = getIteratorsOfSubsegment(bounds);
-                const Unit minimum = *std::min_element(startIterator, endIterator);
-                const Unit length = bounds.endIndex != 0 ? (bounds.endIndex-bounds.startIndex) : 0; // 0 signifies that the subsegment is until the end
-                result.push_back(minimum);
-                result.push_back(length);
-
-                std::for_each(startIterator, endIterator, [&](const Unit unit) {
-                    result.push_back(unit-minimum);});
-                //LOG("Done processing this header");
-            };
-
-            //LOG("constructing the subsegments");
-            std::vector<SubsegmentBounds> subsegments = getSubsegments(block);
-            //LOG("Processing the headers");
-            std::for_each(subsegments.begin(), subsegments.end(), processHeader);
-
-            //LOG("returning the results");
+            apply_into(block, result);
             return result;
         }
 
-
-        Block undo_copy(const Block& block) const override {
-            Block result;
-            size_t index = 0;
-
-            auto readByte = [&]() -> Unit {return block[index++];};
-            auto readStarter = [&]() -> SubsegmentDescriptor {
-                return {readByte(), readByte()};
-            };
-
-            auto processDescriptor = [&](const SubsegmentDescriptor& descriptor) {
-                auto emitUndoneValue = [&](){result.push_back(readByte() + descriptor.minimum);};
-                if (descriptor.length != 0)
-                    repeat(descriptor.length, [&](){emitUndoneValue();});
-                else {
-                    while (index < block.size())
-                        emitUndoneValue();
-                }
+        void apply_into(const Block& block, Block& output) const override {
+            output.clear();
+            if (block.empty()) return;
+
+            const OffsetKernels& kernels = getOffsetKernels();
+            const Unit* data = block.data();
+            const size_t size = block.size();
+            output.resize(size + 2*(size/(minSegmentSize+1)+1)); //every subsegment except the last one is longer than minSegmentSize
+            size_t writeIndex = 0;
+
+            auto emitSubsegment = [&](const size_t start, const size_t end, const Unit minimum, const bool isLast) {
+                output[writeIndex++] = minimum;
+                output[writeIndex++] = isLast ? 0 : (end-start); // 0 signifies that the subsegment is until the end
+                kernels.subtractOffset(data+start, output.data()+writeIndex, end-start, minimum);
+                writeIndex += end-start;
             };
 
-            while (index<block.size()) {
-                SubsegmentDescriptor descriptor = readStarter();
-                //LOG("The descriptor is min=", ((int)descriptor.minimum), ", and the length=", ((int)descriptor.length));
-                processDescriptor(descriptor);
-
+            if (size < peekDistance*2) {
+                emitSubsegment(0, size, kernels.minimum(data, size), true);
+                output.resize(writeIndex);
+                return;
             }
-            return result;
-        }
-
-    private://helpers
-        size_t getLocalMinimumDifference (const size_t index, const Block& block) const {
-            auto min4 = [](const Unit a, const Unit b, const Unit c, const Unit d) -> Unit{
-                return std::min(std::min(a, b), std::min(c, d)); //for cache locality
-            };
 
-            auto minOfConsecutive = [&](const size_t index) {
-                return min4(block[index], block[index+1], block[index+2], block[index+3]);
+            auto windowMinimum = [&](const size_t index) -> Unit {
+                return std::min(std::min(data[index], data[index+1]), std::min(data[index+2], data[index+3]));
             };
-            const Unit minLeft = minOfConsecutive(index-peekDistance);
-            const Unit minRight = minOfConsecutive(index);
-            return safeAbsDifference(minLeft, minRight);
-        };
-
 
-        std::vector<SubsegmentBounds> getSubsegments (const Block& block) const {
-            if (block.size() < peekDistance*2) {
-                const SubsegmentBounds entirety{0, 0};
-                return {entirety};
-            }
+            //the window starting at i is compared with the one starting at i-peekDistance, which is still in the ring
+            Unit recentWindowMinimums[windowSize];
+            for (size_t i=0;i<peekDistance;i++)
+                recentWindowMinimums[i] = windowMinimum(i);
 
-            std::vector<SubsegmentBounds> subsegments;
             size_t currentStart = 0;
-            const size_t threshold = 3;
-            const size_t minSegmentSize = 4;
-            const size_t maxSegmentSize = 255;
-
-            size_t lastDifference = 0;
-            for (size_t i=peekDistance;i<block.size()-peekDistance;i++) {
-                //LOG("at i=", i, "the minimum distance is ", getLocalMinimumDifference(i, block));
-                if (safeAbsDifference(getLocalMinimumDifference(i, block), lastDifference) >= threshold && isInInterval_inclusive(i-currentStart, minSegmentSize, maxSegmentSize)) {
-                    subsegments.emplace_back(currentStart, i+1);
+            Unit currentMinimum = kernels.minimum(data, peekDistance);
+            const size_t scanEnd = size-peekDistance;
+            for (size_t i=peekDistance;i<scanEnd;i++) {
+                recentWindowMinimums[i%windowSize] = windowMinimum(i);
+                currentMinimum = std::min(currentMinimum, data[i]);
+                const size_t difference = safeAbsDifference(recentWindowMinimums[(i-peekDistance)%windowSize], recentWindowMinimums[i%windowSize]);
+                if (difference >= threshold && isInInterval_inclusive(i-currentStart, minSegmentSize, maxSegmentSize)) {
+                    emitSubsegment(currentStart, i+1, currentMinimum, false);
                     currentStart = i+1;
+                    currentMinimum = highestUnsignedValue<Unit>();
                 }
             }
-            subsegments.emplace_back(currentStart, 0); //means that the segment is until the end
-            return subsegments;
-        };
 
+            currentMinimum = std::min(currentMinimum, kernels.minimum(data+scanEnd, size-scanEnd));
+            emitSubsegment(currentStart, size, currentMinimum, true);
+            output.resize(writeIndex);
+        }
+
+
+        Block undo_copy(const Block& block) const override {
+            Block result;
+            undo_into(block, result);
+            return result;
+        }
+
+        void undo_into(const Block& block, Block& output) const override {
+            const OffsetKernels& kernels = getOffsetKernels();
+            output.resize(block.size()); //an upper bound, every subsegment has a header
+            size_t readIndex = 0;
+            size_t writeIndex = 0;
+            while (readIndex+1 < block.size()) {
+                const Unit minimum = block[readIndex++];
+                const Unit length = block[readIndex++];
+                const size_t remaining = block.size()-readIndex;
+                const size_t amount = (length != 0) ? std::min<size_t>(length, remaining) : remaining;
+                kernels.addOffset(block.data()+readIndex, output.data()+writeIndex, amount, minimum);
+                readIndex += amount;
+                writeIndex += amount;
+            }
+            output.resize(writeIndex);
+        }
     };
 
 } // GC
@@ -16,23 +16,33 @@ namespace GC {
         std::string to_string() const { return "{SubtractAverageTransform}";}
 
         Block apply_copy(const Block& block) const {
-            Unit average = StatisticalFeatures::getAverage(block);
             Block result;
-            result.push_back(average);
-            for (const auto& unit: block)
-                result.push_back(unit - average);
+            apply_into(block, result);
             return result;
         }
 
+        void apply_into(const Block& block, Block& output) const {
+            const Unit average = StatisticalFeatures::getAverage(block);
+            output.resize(block.size()+1);
+            output[0] = average;
+            for (size_t i=0;i<block.size();i++)
+                output[i+1] = block[i] - average;
+        }
+
         Block undo_copy(const Block& block) const {
-            ASSERT_NOT_EMPTY(block);
-            Unit average = block[0];
-            Block result(block.size()-1);
-            for (size_t i=0;i<result.size();i++)
-                result[i] = block[i+1]+average;
+            Block result;
+            undo_into(block, result);
             return result;
         }
 
+        void undo_into(const Block& block, Block& output) const {
+            ASSERT_NOT_EMPTY(block);
+            const Unit average = block[0];
+            output.resize(block.size()-1);
+            for (size_t i=0;i<output.size();i++)
+                output[i] = block[i+1]+average;
+        }
+
     };
 
 } // GC
@@ -16,23 +16,33 @@ namespace GC {
         std::string to_string() const {return "{DeltaXORTransform}";}
 
         Block apply_copy(const Block& block) const {
-            Unit xorAverage = BlockReport::getXorAverage(block);
             Block result;
-            result.push_back(xorAverage);  //write the average, so that the decompressor knows what to unxor
-            for (const auto& unit : block)
-                result.push_back(unit ^ xorAverage);
+            apply_into(block, result);
             return result;
         }
 
+        void apply_into(const Block& block, Block& output) const {
+            const Unit xorAverage = BlockReport::getXorAverage(block);
+            output.resize(block.size()+1);
+            output[0] = xorAverage;  //write the average, so that the decompressor knows what to unxor
+            for (size_t i=0;i<block.size();i++)
+                output[i+1] = block[i] ^ xorAverage;
+        }
+
         Block undo_copy(const Block& block) const {
-            ASSERT_NOT_EMPTY(block);
-            Unit xorAverage = block[0];
-            Block result(block.size()-1);
-            for (size_t i=0;i<result.size();i++)
-                result[i] = block[i+1]^xorAverage;
+            Block result;
+            undo_into(block, result);
             return result;
         }
 
+        void undo_into(const Block& block, Block& output) const {
+            ASSERT_NOT_EMPTY(block);
+            const Unit xorAverage = block[0];
+            output.resize(block.size()-1);
+            for (size_t i=0;i<output.size();i++)
+                output[i] = block[i+1]^xorAverage;
+        }
+
     };
 
 } // GC
@@ -0,0 +1,55 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_MAILBOX_HPP
+#define EVOCOM_MAILBOX_HPP
+
+#include <array>
+#include <atomic>
+#include <optional>
+#include <type_traits>
+
+namespace GC {
+
+    /**
+     * A bounded queue between exactly one sending thread and one receiving thread, which never locks:
+     * the sender only writes tail and the receiver only writes head, and the slot is published by the release store of tail.
+     * The messages are copied in and out, so they have to be trivially copyable.
+     */
+    template <class Message, size_t Capacity>
+    class Mailbox {
+        static_assert(std::is_trivially_copyable_v<Message>, "messages are copied between threads without synchronising their contents");
+
+        std::array<Message, Capacity> slots;
+        alignas(64) std::atomic<size_t> head{0}; //the next message to be taken, only written by the receiver
+        alignas(64) std::atomic<size_t> tail{0}; //the next free slot, only written by the sender
+
+    public:
+        /**
+         * Only called by the sender
+         * @return false if the mailbox is full
+         */
+        bool tryPost(const Message& message) {
+            const size_t currentTail = tail.load(std::memory_order_relaxed);
+            if (currentTail - head.load(std::memory_order_acquire) == Capacity) return false;
+            slots[currentTail % Capacity] = message;
+            tail.store(currentTail+1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Only called by the receiver
+         */
+        std::optional<Message> tryTake() {
+            const size_t currentHead = head.load(std::memory_order_relaxed);
+            if (currentHead == tail.load(std::memory_order_acquire)) return {};
+            const Message message = slots[currentHead % Capacity];
+            head.store(currentHead+1, std::memory_order_release);
+            return message;
+        }
+    };
+
+} // GC
+
+#endif //EVOCOM_MAILBOX_HPP
@@ -0,0 +1,123 @@
+//
+// Created by gian on 19/10/26.
+//
+
+#ifndef EVOCOM_THREADPOOL_HPP
+#define EVOCOM_THREADPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GC {
+
+    /**
+     * A fixed set of worker threads which run batches of indexed tasks.
+     * forEachIndex hands out the indexes dynamically (whoever is free takes the next one), and the calling thread works too,
+     * so a pool of threadAmount threads only starts threadAmount-1 workers.
+     *
+     * The order in which the indexes are run is not fixed, so each task should only write to its own slot of the output.
+     */
+    class ThreadPool {
+    public:
+        using Task = std::function<void(size_t)>;
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::condition_variable workFinished;
+
+        const Task* currentTask = nullptr;
+        size_t taskAmount = 0;
+        std::atomic<size_t> nextIndex{0};
+        size_t round = 0;           //incremented for every batch, so that the workers know there's something new
+        size_t busyWorkers = 0;
+        bool stopping = false;
+
+        void runAvailableIndexes() {
+            for (size_t index = nextIndex.fetch_add(1); index < taskAmount; index = nextIndex.fetch_add(1))
+                (*currentTask)(index);
+        }
+
+        void workerLoop() {
+            size_t lastRound = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    workAvailable.wait(lock, [&](){return stopping || round != lastRound;});
+                    if (stopping) return;
+                    lastRound = round;
+                }
+                runAvailableIndexes();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    busyWorkers--;
+                    if (busyWorkers == 0) workFinished.notify_one();
+                }
+            }
+        }
+
+    public:
+        static size_t getDefaultThreadAmount() {
+            return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        explicit ThreadPool(const size_t threadAmount) {
+            const size_t workerAmount = std::max<size_t>(threadAmount, 1) - 1;
+            workers.reserve(workerAmount);
+            for (size_t i=0;i<workerAmount;i++)
+                workers.emplace_back([this](){workerLoop();});
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            workAvailable.notify_all();
+            for (std::thread& worker: workers) worker.join();
+        }
+
+        size_t getThreadAmount() const {
+            return workers.size()+1;
+        }
+
+        /**
+         * Runs task(i) for every i in [0, amount), and returns when all of them are done.
+         * Must not be called by more than one thread at a time, nor from inside a task.
+         */
+        void forEachIndex(const size_t amount, const Task& task) {
+            if (workers.empty() || amount < 2) {
+                for (size_t i=0;i<amount;i++) task(i);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                currentTask = &task;
+                taskAmount = amount;
+                nextIndex = 0;
+                busyWorkers = workers.size();
+                round++;
+            }
+            workAvailable.notify_all();
+
+            runAvailableIndexes();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            workFinished.wait(lock, [&](){return busyWorkers == 0;});
+            currentTask = nullptr;
+        }
+    };
+
+} // GC
+
+#endif //EVOCOM_THREADPOOL_HPP
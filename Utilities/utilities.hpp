@@ -184,15 +184,15 @@ T square(const T x) {return x*x;}
 
 
 /**
- * Calculates the Levenshtine distance between 2 vectors, used for calculating the distance during FAE
+ * Calculates the Levenshtine distance between 2 vectors (or any indexable lists), used for calculating the distance during FAE
  * @tparam Item items which can only be compared using the discrete metric
  * @tparam MaxLength max Length allowed of the vectors
  * @param X first vector, has size at most MaxLength
  * @param Y second vector, has size at most MaxLength
  * @return  return the integer representing the distance
  */
-template <class Item, size_t MaxLength>
-size_t LevenshteinDistance(const std::vector<Item>& X, const std::vector<Item>& Y) {
+template <class Item, size_t MaxLength, class List = std::vector<Item>>
+size_t LevenshteinDistance(const List& X, const List& Y) {
     //LOG_NOSPACES("Called Lev(", containerToString(X), ", ", containerToString(Y), ")");
 
     constexpr size_t maxLengthOfList = MaxLength+1;